@@ -1,3 +1,4 @@
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 
@@ -21,6 +22,9 @@ class FileUtils {
         return true;
     }
 
+    /* Check if a file name means stdin or stdout rather than a file */
+    static bool isStdStream(const string& fileName) { return fileName == "-"; }
+
     /* Check if given file is empty */
     static bool isEmptyFile(string fileName) {
         ifstream inFile;
@@ -28,4 +32,20 @@ class FileUtils {
         inFile.get();
         return inFile.eof();
     }
+
+    /* Write the low numBytes bytes of value, least significant byte first */
+    static void writeInt(ostream& out, uint64_t value, int numBytes) {
+        for (int i = 0; i < numBytes; i++) {
+            out.put((char)(value >> (8 * i)));
+        }
+    }
+
+    /* Read a numBytes byte integer written by writeInt */
+    static uint64_t readInt(istream& in, int numBytes) {
+        uint64_t value = 0;
+        for (int i = 0; i < numBytes; i++) {
+            value |= uint64_t((unsigned char)in.get()) << (8 * i);
+        }
+        return value;
+    }
 };
@@ -0,0 +1,71 @@
+#ifndef BITCURSOR_HPP
+#define BITCURSOR_HPP
+
+#include <cstdint>
+#include <cstring>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** Reads bits MSB-first straight from a byte array in memory. It works like
+ * BitInputStream, with a 64-bit window behind peekBits()/consumeBits(), but
+ * it refills the window with a single 8-byte load and has no istream behind
+ * it. It is small enough that a decoder can keep several cursors going at
+ * once. Reads past the end of the array return 0s.
+ */
+class BitCursor {
+  private:
+    const byte* data;   // bytes to read from
+    size_t size;        // number of bytes at data
+    size_t pos;         // index of the next byte not yet in the window
+    uint64_t window;    // bit window, the next bit is the most significant
+    unsigned int nbits; // number of valid bits in window
+
+    // top up the window to at least 56 bits
+    void refill() {
+        if (pos <= size && size - pos >= 8) {
+            // bits loaded past nbits are the same bits the next load puts
+            // there, so loading them early does no harm
+            uint64_t next;
+            memcpy(&next, data + pos, 8);
+            window |= __builtin_bswap64(next) >> nbits;
+            pos += (63 - nbits) >> 3;
+            nbits |= 56;
+            return;
+        }
+
+        // near the end of the data, one byte at a time padded with 0s
+        while (nbits <= 56) {
+            byte next = pos < size ? data[pos] : 0;
+            window |= uint64_t(next) << (56 - nbits);
+            pos++;
+            nbits += 8;
+        }
+    }
+
+  public:
+    BitCursor(const byte* data = nullptr, size_t size = 0)
+        : data(data), size(size), pos(0), window(0), nbits(0) {}
+
+    /* Return the next n bits (1 <= n <= 56) without consuming them */
+    uint64_t peekBits(unsigned int n) {
+        if (nbits < n) refill();
+        return window >> (64 - n);
+    }
+
+    /* Drop the next n bits; they must have been peeked at already */
+    void consumeBits(unsigned int n) {
+        window <<= n;
+        nbits -= n;
+    }
+
+    /* Read the next n bits (1 <= n <= 56) */
+    uint64_t readBits(unsigned int n) {
+        uint64_t bits = peekBits(n);
+        consumeBits(n);
+        return bits;
+    }
+};
+
+#endif  // BITCURSOR_HPP
@@ -2,20 +2,48 @@
 
 // TODO: Fill the buffer from the input stream.
 void BitInputStream::fill() {
-    buf = in.get();
-    nbits = 0;
+    in.read((char*)buffer.data(), buffer.size());
+    bufLen = in.gcount();
+    bufPos = 0;
+}
+
+/* Top up the window one whole byte at a time, only reading from the istream
+ * when the block buffer runs dry and more bits are still needed */
+void BitInputStream::refill(unsigned int n) {
+    while (nbits <= 56) {
+        if (bufPos == bufLen) {
+            if (nbits >= n) return;
+            fill();
+            // end of input, pad the window with 0s
+            if (bufLen == 0) {
+                nbits += 8;
+                padBits += 8;
+                continue;
+            }
+        }
+        window |= uint64_t(buffer[bufPos++]) << (56 - nbits);
+        nbits += 8;
+    }
 }
 
 // TODO: Read the next bit from the buffer.
 unsigned int BitInputStream::readBit() {
-    // fill buffer if read all values
-    if (nbits >= 8) fill();
-
-    unsigned char temp = buf;
-    temp = (buf >> (7 - nbits)) & 1;
-    nbits++;
+    unsigned int bit = peekBits(1);
+    consumeBits(1);
+    return bit;
+}
 
-    return temp;
+/* Read the next n bits (0 <= n <= 64), the first bit read ends up as the most
+ * significant bit of the result */
+uint64_t BitInputStream::readBits(unsigned int n) {
+    if (n == 0) return 0;
+    if (n > 56) {
+        uint64_t high = readBits(n - 32);
+        return (high << 32) | readBits(32);
+    }
+    uint64_t bits = peekBits(n);
+    consumeBits(n);
+    return bits;
 }
 
 /*
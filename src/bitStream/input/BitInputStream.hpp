@@ -6,30 +6,65 @@
 #ifndef BITINPUTSTREAM_HPP
 #define BITINPUTSTREAM_HPP
 
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 typedef unsigned char byte;
 
 using namespace std;
 
+/** Reads bits MSB-first from an istream. Bytes are read from the istream
+ * bufSize at a time into a block buffer, and the block buffer refills a
+ * 64-bit bit window that peekBits()/consumeBits() work on. The default
+ * bufSize of 1 never reads further ahead than the bits asked for, so the
+ * istream can still be used directly once the bits are read.
+ */
 class BitInputStream {
   private:
-    istream& in;         // reference to the input stream to use
-    byte buf;            // one byte buffer of bits
-    unsigned int nbits;  // number of bits that have been writen to buf
+    istream& in;          // reference to the input stream to use
+    vector<byte> buffer;  // block of bytes read from in
+    size_t bufPos;        // index of the next unused byte in buffer
+    size_t bufLen;        // number of valid bytes in buffer
+    uint64_t window;      // bit window, the next bit is the most significant
+    unsigned int nbits;   // number of valid bits in window
+    uint64_t padBits;     // number of 0s shifted in past the end of in
+
+    // move bytes from the block buffer into the window until it holds at
+    // least n bits (past the end of the input, 0s are shifted in)
+    void refill(unsigned int n);
 
   public:
     // TODO: Initialize member variables.
-    explicit BitInputStream(istream& is) : in(is) {
-        buf = in.get();
-        nbits = 0;
+    explicit BitInputStream(istream& is, size_t bufSize = 1)
+        : in(is), bufPos(0), bufLen(0), window(0), nbits(0), padBits(0) {
+        buffer.resize(bufSize == 0 ? 1 : bufSize);
     };
 
     void fill();
 
     unsigned int readBit();
 
+    /* Return the next n bits (1 <= n <= 56) without consuming them */
+    uint64_t peekBits(unsigned int n) {
+        if (nbits < n) refill(n);
+        return window >> (64 - n);
+    }
+
+    /* Drop the next n bits; they must have been peeked at already */
+    void consumeBits(unsigned int n) {
+        window <<= n;
+        nbits -= n;
+    }
+
+    uint64_t readBits(unsigned int n);
+
+    /* True once a bit from past the end of the input has been consumed.
+     * The padding always sits behind the real bits in the window, so some
+     * of it is gone when there is more of it than there are bits left */
+    bool isExhausted() const { return padBits > nbits; }
+
     void printBuffer();
 };
 
-#endif
\ No newline at end of file
+#endif
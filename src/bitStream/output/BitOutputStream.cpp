@@ -1,5 +1,11 @@
 #include "BitOutputStream.hpp"
 
+/* Write all completed bytes in the byte buffer to the ostream in one call */
+void BitOutputStream::writeBuffer() {
+    out.write((const char*)buffer.data(), bufLen);
+    bufLen = 0;
+}
+
 /**
  * TODO: Write the buffer to the output stream,
  * and then clear the buffer to allow further use.
@@ -9,11 +15,13 @@
  * may cause a timeout.
  */
 unsigned int BitOutputStream::flush() {
-    out << buf;
+    // pad the last (possibly empty) partial byte with 0s
+    buffer[bufLen++] = (byte)(acc << (8 - nbits));
+    writeBuffer();
 
     // record how many padded 0s
     unsigned int tempNBits = nbits;
-    buf = 0;
+    acc = 0;
     nbits = 0;
     return 8 - tempNBits;
 }
@@ -23,13 +31,33 @@ unsigned int BitOutputStream::flush() {
  * Flushes the buffer first if it is full (which means all the bits in the
  * buffer have already been set). You may assume the given int is either 0 or 1.
  */
-void BitOutputStream::writeBit(unsigned int i) {
-    // flush buffer if full
-    if (nbits >= 8) flush();
+void BitOutputStream::writeBit(unsigned int i) { writeBits(i, 1); }
+
+/**
+ * Write the low len bits of code to the bit buffer, most significant bit
+ * first. Any len from 0 to 64 is accepted.
+ */
+void BitOutputStream::writeBits(uint64_t code, unsigned int len) {
+    if (len == 0) return;
+
+    // acc never holds more than 8 pending bits, so 56 more always fit
+    if (len > 56) {
+        writeBits(code >> 32, len - 32);
+        writeBits(code, 32);
+        return;
+    }
+
+    acc = (acc << len) | (code & ((uint64_t(1) << len) - 1));
+    nbits += len;
+
+    // move completed bytes to the byte buffer, keeping a full last byte
+    // pending so flush() still reports 0 padded bits for it
+    while (nbits > 8) {
+        nbits -= 8;
+        buffer[bufLen++] = (byte)(acc >> nbits);
+    }
 
-    // shift LSB left, then 'or' to update buf
-    buf |= i << (7 - nbits);
-    nbits++;
+    if (bufLen >= bufSize) writeBuffer();
 }
 
 /*
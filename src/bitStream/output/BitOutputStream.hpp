@@ -6,30 +6,55 @@
 #ifndef BITOUTPUTSTREAM_HPP
 #define BITOUTPUTSTREAM_HPP
 
+#include <cstdint>
 #include <iostream>
+#include <vector>
 
 typedef unsigned char byte;
 
 using namespace std;
 
-/** TODO: class header */
+/** Writes bits MSB-first to an ostream. Bits are collected in a 64-bit
+ * accumulator, completed bytes go to an internal byte buffer, and the byte
+ * buffer is handed to the ostream once it holds bufSize bytes. The default
+ * bufSize of 1 writes every completed byte straight through.
+ */
 class BitOutputStream {
   private:
-    ostream& out;        // reference to the output stream to use
-    byte buf;            // one byte buffer of bits
-    unsigned int nbits;  // number of bits have been writen to buf
+    ostream& out;         // reference to the output stream to use
+    uint64_t acc;         // accumulator, pending bits are the low nbits bits
+    unsigned int nbits;   // number of pending bits in acc (at most 8 between
+                          // calls, so a partial byte is never written early)
+    vector<byte> buffer;  // completed bytes waiting to be written to out
+    size_t bufLen;        // number of completed bytes in buffer
+    size_t bufSize;       // number of bytes to collect before writing to out
+
+    // write all completed bytes in buffer to the ostream
+    void writeBuffer();
 
   public:
     // TODO: Initialize member variables.
-    explicit BitOutputStream(ostream& os) : out(os) {
-        buf = 0;
-        nbits = 0;
+    explicit BitOutputStream(ostream& os, size_t bufSize = 1)
+        : out(os),
+          acc(0),
+          nbits(0),
+          bufLen(0),
+          bufSize(bufSize == 0 ? 1 : bufSize) {
+        // one writeBits call completes at most 8 bytes past bufSize
+        buffer.resize(this->bufSize + 8);
     };
 
     unsigned int flush();
 
+    /* Write the completed bytes to the ostream now instead of once bufSize
+     * of them are collected. The last byte stays pending, so the bit
+     * stream goes on unchanged */
+    void writeCompleted() { writeBuffer(); }
+
     void writeBit(unsigned int i);
 
+    void writeBits(uint64_t code, unsigned int len);
+
     void printBuf();
 };
 
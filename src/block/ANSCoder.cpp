@@ -0,0 +1,203 @@
+#include "ANSCoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "BlockFormat.hpp"
+#include "MemoryStream.hpp"
+
+const unsigned int ANSCoder::MIN_TABLE_LOG;
+const unsigned int ANSCoder::MAX_TABLE_LOG;
+const unsigned int ANSCoder::DEFAULT_TABLE_LOG;
+
+/* Index of the highest set bit of x, which must not be 0 */
+static unsigned int highBit(uint32_t x) { return 31 - __builtin_clz(x); }
+
+ANSCoder::ANSCoder(unsigned int tableLog)
+    : tableLog(max(MIN_TABLE_LOG, min(tableLog, MAX_TABLE_LOG))) {}
+
+vector<unsigned int> ANSCoder::normalize(const vector<unsigned int>& freqs,
+                                         unsigned int tableLog) {
+    uint32_t tableSize = uint32_t(1) << tableLog;
+    vector<unsigned int> scaled(256, 0);
+    uint64_t total = 0;
+    for (int i = 0; i < 256; i++) total += freqs[i];
+    if (total == 0) return scaled;
+
+    uint64_t sum = 0;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] == 0) continue;
+        scaled[i] =
+            max(uint64_t(1), uint64_t(freqs[i]) * tableSize / total);
+        sum += scaled[i];
+    }
+
+    // the largest frequencies absorb the rounding, no symbol drops below 1
+    // (the table holds at least 256 entries, so one is always above 1)
+    while (sum != tableSize) {
+        int largest = max_element(scaled.begin(), scaled.end()) -
+                      scaled.begin();
+        if (sum < tableSize) {
+            scaled[largest] += tableSize - sum;
+            sum = tableSize;
+        } else {
+            scaled[largest]--;
+            sum--;
+        }
+    }
+    return scaled;
+}
+
+vector<byte> ANSCoder::spread(const vector<unsigned int>& norm,
+                              unsigned int tableLog) {
+    // an odd step visits every position once, and scatters each symbol's
+    // positions over the whole table
+    uint32_t tableSize = uint32_t(1) << tableLog;
+    uint32_t mask = tableSize - 1;
+    uint32_t step = (tableSize >> 1) + (tableSize >> 3) + 3;
+    vector<byte> table(tableSize);
+    uint32_t pos = 0;
+    for (int s = 0; s < 256; s++) {
+        for (unsigned int k = 0; k < norm[s]; k++) {
+            table[pos] = s;
+            pos = (pos + step) & mask;
+        }
+    }
+    return table;
+}
+
+void ANSCoder::build(const vector<unsigned int>& freqs) {
+    counts = freqs;
+    norm = normalize(freqs, tableLog);
+}
+
+uint64_t ANSCoder::encodedSize() const {
+    unsigned int numSymbols = 0;
+    double bits = tableLog;
+    for (int s = 0; s < 256; s++) {
+        if (counts[s] == 0) continue;
+        numSymbols++;
+        bits += counts[s] * (tableLog - log2((double)norm[s]));
+    }
+    return 2 + 3 * numSymbols + 4 + (uint64_t)ceil(bits / 8);
+}
+
+void ANSCoder::encode(const byte* data, size_t n, vector<byte>& out) const {
+    uint32_t tableSize = uint32_t(1) << tableLog;
+    vector<byte> table = spread(norm, tableLog);
+
+    // the states of each symbol, in the order of their table positions
+    vector<uint32_t> cumul(257, 0);
+    for (int s = 0; s < 256; s++) cumul[s + 1] = cumul[s] + norm[s];
+    vector<uint16_t> stateTable(tableSize);
+    vector<uint32_t> next(cumul.begin(), cumul.end() - 1);
+    for (uint32_t u = 0; u < tableSize; u++) {
+        stateTable[next[table[u]]++] = tableSize + u;
+    }
+
+    // a state at or above minStatePlus sends maxBitsOut bits, the rest one
+    // bit less; deltaNbBits folds that test into one add and shift
+    uint32_t deltaNbBits[256];
+    int32_t deltaFindState[256];
+    unsigned int numSymbols = 0;
+    for (int s = 0; s < 256; s++) {
+        if (norm[s] == 0) continue;
+        numSymbols++;
+        unsigned int maxBitsOut =
+            norm[s] == 1 ? tableLog : tableLog - highBit(norm[s] - 1);
+        deltaNbBits[s] = (maxBitsOut << 16) - (norm[s] << maxBitsOut);
+        deltaFindState[s] = (int32_t)cumul[s] - (int32_t)norm[s];
+    }
+
+    // encode back to front, keeping the bits of every byte: the value in
+    // the high bits, the number of bits in the low 8
+    vector<uint32_t> chunks(n);
+    uint32_t state = tableSize;
+    uint64_t bitCount = tableLog;
+    for (size_t i = n; i-- > 0;) {
+        byte s = data[i];
+        uint32_t nbBits = (state + deltaNbBits[s]) >> 16;
+        chunks[i] = (state & ((uint32_t(1) << nbBits) - 1)) << 8 | nbBits;
+        bitCount += nbBits;
+        state = stateTable[(int32_t)(state >> nbBits) + deltaFindState[s]];
+    }
+
+    out.reserve(out.size() + 2 + 3 * numSymbols + 4 + bitCount / 8 + 1);
+    out.push_back((byte)tableLog);
+    out.push_back((byte)(numSymbols - 1));
+    for (int s = 0; s < 256; s++) {
+        if (norm[s] == 0) continue;
+        out.push_back((byte)s);
+        putInt(out, norm[s], 2);
+    }
+    putInt(out, bitCount, 4);
+
+    // the decoder starts from the final state, then reads front to back
+    VectorOutputStream os(out);
+    BitOutputStream bos(os, BLOCK_BIT_BUFFER_SIZE);
+    bos.writeBits(state - tableSize, tableLog);
+    for (size_t i = 0; i < n; i++) {
+        bos.writeBits(chunks[i] >> 8, chunks[i] & 0xFF);
+    }
+    bos.flush();
+}
+
+bool ANSCoder::decode(const byte* payload, size_t size, byte* out,
+                      size_t n) const {
+    if (size < 2) return false;
+    unsigned int tableLog = payload[0];
+    unsigned int numSymbols = payload[1] + 1;
+    if (tableLog < MIN_TABLE_LOG || tableLog > MAX_TABLE_LOG ||
+        size < 2 + 3 * numSymbols + 4) {
+        return false;
+    }
+
+    // the scaled frequencies must fill the table exactly
+    uint32_t tableSize = uint32_t(1) << tableLog;
+    vector<unsigned int> norm(256, 0);
+    size_t pos = 2;
+    uint64_t total = 0;
+    for (unsigned int k = 0; k < numSymbols; k++, pos += 3) {
+        byte s = payload[pos];
+        unsigned int freq = getInt(payload + pos + 1, 2);
+        if (freq == 0 || norm[s] != 0) return false;
+        norm[s] = freq;
+        total += freq;
+    }
+    if (total != tableSize) return false;
+
+    // the bit stream must fit in the rest of the payload
+    uint64_t bitCount = getInt(payload + pos, 4);
+    pos += 4;
+    if ((bitCount + 7) / 8 > size - pos) return false;
+
+    // the k-th position of a symbol s leads to the states from
+    // (norm[s] + k) << nbBits on, which always lie in the table
+    vector<byte> table = spread(norm, tableLog);
+    vector<DecodeEntry> entries(tableSize);
+    vector<uint32_t> next(norm.begin(), norm.end());
+    for (uint32_t u = 0; u < tableSize; u++) {
+        byte s = table[u];
+        uint32_t x = next[s]++;
+        unsigned int nbBits = tableLog - highBit(x);
+        entries[u].newState = (x << nbBits) - tableSize;
+        entries[u].symbol = s;
+        entries[u].nbBits = nbBits;
+    }
+
+    MemoryInputStream stream(payload + pos, size - pos);
+    BitInputStream bis(stream, BLOCK_BIT_BUFFER_SIZE);
+    uint32_t state = bis.peekBits(tableLog);
+    bis.consumeBits(tableLog);
+    for (size_t i = 0; i < n; i++) {
+        const DecodeEntry& e = entries[state];
+        out[i] = e.symbol;
+        // peek a whole tableLog bits so no entry needs a 0 bit peek
+        uint32_t bits = bis.peekBits(tableLog) >> (tableLog - e.nbBits);
+        bis.consumeBits(e.nbBits);
+        state = e.newState + bits;
+    }
+    return true;
+}
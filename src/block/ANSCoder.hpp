@@ -0,0 +1,73 @@
+#ifndef ANSCODER_HPP
+#define ANSCODER_HPP
+
+#include <cstdint>
+#include <vector>
+#include "EntropyCoder.hpp"
+
+using namespace std;
+
+/** A table-based asymmetric numeral system coder (tANS, as in FSE), the
+ * coder of an ANS_BLOCK. The byte frequencies are scaled to add up to the
+ * table size 1 << tableLog, and the symbols are spread over the table in
+ * proportion to them. A symbol then costs close to log2(table size /
+ * frequency) bits, a fraction of a bit where Huffman needs at least one.
+ *
+ * ANS decodes in the opposite order it encodes, so the encoder works from
+ * the last byte back and then writes the bits out front to back. The
+ * decoder reads the stream forwards: each table entry gives the symbol, the
+ * number of bits to read, and the base of the next state.
+ *
+ * The payload is tableLog (1 byte), the symbol count minus 1 (1 byte),
+ * (symbol, frequency) pairs with 2-byte frequencies, the number of bits in
+ * the bit stream (4 bytes), and the bit stream: the final encoder state in
+ * tableLog bits, then the bits of every byte in order.
+ */
+class ANSCoder : public EntropyCoder {
+  public:
+    /* Range of table sizes, as powers of 2, all 256 symbols always fit */
+    static const unsigned int MIN_TABLE_LOG = 8;
+    static const unsigned int MAX_TABLE_LOG = 12;
+
+    /* Default table size, 2048 entries of 4 bytes fit in L1 cache */
+    static const unsigned int DEFAULT_TABLE_LOG = 11;
+
+  private:
+    /* Decoder state, the next state is newState plus the next nbBits bits */
+    struct DecodeEntry {
+        uint16_t newState;
+        byte symbol;
+        uint8_t nbBits;
+    };
+
+    unsigned int tableLog;       // table size is 1 << tableLog
+    vector<unsigned int> counts;  // histogram the code was built for
+    vector<unsigned int> norm;   // scaled frequencies, add up to table size
+
+    // symbol of every table position
+    static vector<byte> spread(const vector<unsigned int>& norm,
+                               unsigned int tableLog);
+
+  public:
+    explicit ANSCoder(unsigned int tableLog = DEFAULT_TABLE_LOG);
+
+    /* Scale freqs to add up to 1 << tableLog, keeping every used symbol */
+    static vector<unsigned int> normalize(const vector<unsigned int>& freqs,
+                                          unsigned int tableLog);
+
+    void build(const vector<unsigned int>& freqs) override;
+
+    /* Scaled frequency of every symbol, once built */
+    const vector<unsigned int>& getNorm() const { return norm; }
+
+    /* Estimated from the scaled frequencies, the bit stream comes out
+     * within a fraction of a percent of it */
+    uint64_t encodedSize() const override;
+
+    void encode(const byte* data, size_t n, vector<byte>& out) const override;
+
+    bool decode(const byte* payload, size_t size, byte* out,
+                size_t n) const override;
+};
+
+#endif  // ANSCODER_HPP
@@ -0,0 +1,447 @@
+#include "BlockCodec.hpp"
+
+#include <cstring>
+
+#include "ANSCoder.hpp"
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "HCCanonical.hpp"
+#include "HCDecodeTable.hpp"
+#include "HCTree.hpp"
+#include "Histogram.hpp"
+#include "MemoryStream.hpp"
+
+/* AUTO_CODER only takes ANS when it saves at least 1 / ANS_MIN_SAVING of
+ * the Huffman payload, as ANS decodes a little slower */
+const uint64_t ANS_MIN_SAVING = 64;
+
+/* A block is stored as it is unless coding saves at least
+ * 1 / STORE_MIN_SAVING of its size, which is not worth a decode pass */
+const uint64_t STORE_MIN_SAVING = 32;
+
+/* Run coding is only tried when at least 1 / RUN_MIN_REPEATS of the bytes
+ * repeat the byte before them */
+const uint64_t RUN_MIN_REPEATS = 4;
+
+/* Fewest bytes a context must have to be considered for its own code */
+const unsigned int MIN_CONTEXT_COUNT = 64;
+
+/* Root table width for context codes, which are few and mostly short, so
+ * building up to 256 tables per block stays cheap */
+const unsigned int CONTEXT_TABLE_BITS = 8;
+
+/* Canonical code lengths of a Huffman code for freqs */
+static vector<unsigned int> buildLengths(const vector<unsigned int>& freqs,
+                                         unsigned int maxCodeLength) {
+    HCTree tree;
+    tree.build(freqs, maxCodeLength);
+    return HCCanonical::codeLengths(tree.getCodes());
+}
+
+/* Number of bits freqs code to with lengths */
+static uint64_t codedBits(const unsigned int* freqs,
+                          const vector<unsigned int>& lengths) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 256; i++) bits += (uint64_t)freqs[i] * lengths[i];
+    return bits;
+}
+
+void BlockCodec::encodeBlock(const byte* data, size_t n,
+                             const BlockOptions& options, vector<byte>& out) {
+    vector<unsigned int> freqs(256);
+    Histogram::count(data, n, freqs);
+
+    // one byte repeated needs nothing but the byte
+    if (n > 0 && freqs[data[0]] == n) {
+        BlockHeader(SINGLE_BLOCK, n, 1).write(out);
+        out.push_back(data[0]);
+        return;
+    }
+
+    HuffmanCoder huffman(options.maxCodeLength);
+    huffman.build(freqs);
+    byte type = options.numStreams > 1 ? INTERLEAVED_BLOCK : HUFFMAN_BLOCK;
+    unsigned int numStreams =
+        max(MIN_STREAMS, min(options.numStreams, MAX_STREAMS));
+
+    // payload size of the chosen type, known before any coding: exact for
+    // Huffman and order-1 blocks, an estimate for ANS, and for interleaved
+    // blocks an upper bound counting a padding byte for every stream
+    uint64_t codedSize = huffman.encodedSize();
+    if (type == INTERLEAVED_BLOCK) codedSize += 1 + 5 * numStreams;
+
+    // a single code block goes to the chosen coder, or to ANS when that is
+    // clearly smaller
+    ANSCoder ans;
+    const EntropyCoder* coder = &huffman;
+    if (type == HUFFMAN_BLOCK && options.coder != HUFFMAN_CODER) {
+        ans.build(freqs);
+        uint64_t huffmanSize = huffman.encodedSize();
+        if (options.coder == ANS_CODER ||
+            ans.encodedSize() + huffmanSize / ANS_MIN_SAVING < huffmanSize) {
+            type = ANS_BLOCK;
+            coder = &ans;
+            codedSize = ans.encodedSize();
+        }
+    }
+
+    // codes keyed by the previous byte, if they beat the single code
+    ContextCodes contextCodes;
+    if (options.order1 && n > 0) {
+        contextCodes = order1Codes(data, n, options.maxCodeLength);
+        uint64_t order1Size =
+            contextCodes.headerSize + 4 + (contextCodes.bitCount + 7) / 8;
+        if (order1Size < codedSize) {
+            type = ORDER1_BLOCK;
+            codedSize = order1Size;
+        }
+    }
+
+    // long runs of a byte (sparse or padded data) are cheaper to code as run
+    // lengths, and expand with memset
+    vector<byte> runs;
+    HuffmanCoder runCoder(options.maxCodeLength);
+    size_t repeats = 0;
+    for (size_t i = 1; i < n; i++) repeats += data[i] == data[i - 1];
+    if (repeats >= n / RUN_MIN_REPEATS) {
+        encodeRuns(data, n, runs);
+        vector<unsigned int> runFreqs(256);
+        Histogram::count(runs.data(), runs.size(), runFreqs);
+        runCoder.build(runFreqs);
+        uint64_t runSize = 4 + runCoder.encodedSize();
+        if (runSize < codedSize) {
+            type = RUN_BLOCK;
+            codedSize = runSize;
+        }
+    }
+
+    // incompressible data (already compressed, encrypted) is copied as is
+    if (codedSize + n / STORE_MIN_SAVING >= n) type = STORED_BLOCK;
+
+    // payload size is filled in once the payload is written
+    size_t headerStart = out.size();
+    BlockHeader(type, n, 0).write(out);
+    size_t payloadStart = out.size();
+
+    if (type == STORED_BLOCK) {
+        out.insert(out.end(), data, data + n);
+    } else if (type == INTERLEAVED_BLOCK) {
+        encodeInterleaved(data, n, huffman.getLengths(), numStreams, out);
+    } else if (type == ORDER1_BLOCK) {
+        encodeOrder1(data, n, contextCodes, out);
+    } else if (type == RUN_BLOCK) {
+        putInt(out, runs.size(), 4);
+        runCoder.encode(runs.data(), runs.size(), out);
+    } else {
+        coder->encode(data, n, out);
+    }
+
+    // the size that picked the type may have been an estimate, the payload
+    // itself decides whether coding was worth it
+    if (type != STORED_BLOCK &&
+        out.size() - payloadStart + n / STORE_MIN_SAVING >= n) {
+        type = STORED_BLOCK;
+        out.resize(payloadStart);
+        out.insert(out.end(), data, data + n);
+    }
+
+    BlockHeader(type, n, out.size() - payloadStart).write(out, headerStart);
+}
+
+void BlockCodec::encodeInterleaved(const byte* data, size_t n,
+                                   const vector<unsigned int>& lengths,
+                                   unsigned int numStreams,
+                                   vector<byte>& out) {
+    vector<HCCode> codes = HCCanonical::codesFromLengths(lengths);
+
+    // code each stream on its own, the sizes go in front of the streams
+    vector<vector<byte>> streams(numStreams);
+    for (unsigned int s = 0; s < numStreams; s++) {
+        VectorOutputStream os(streams[s]);
+        BitOutputStream bos(os, BLOCK_BIT_BUFFER_SIZE);
+        for (size_t i = s; i < n; i += numStreams) {
+            bos.writeBits(codes[data[i]].bits, codes[data[i]].length);
+        }
+        bos.flush();
+    }
+
+    VectorOutputStream os(out);
+    HCCanonical::writeLengths(os, lengths);
+    out.push_back((byte)numStreams);
+    for (const vector<byte>& stream : streams) putInt(out, stream.size(), 4);
+    for (const vector<byte>& stream : streams) {
+        out.insert(out.end(), stream.begin(), stream.end());
+    }
+}
+
+BlockCodec::ContextCodes BlockCodec::order1Codes(const byte* data, size_t n,
+                                                 unsigned int maxCodeLength) {
+    // counts[256 * c + s] is how often s follows context c
+    vector<unsigned int> counts(256 * 256);
+    byte prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        counts[256 * prev + data[i]]++;
+        prev = data[i];
+    }
+
+    vector<unsigned int> freqs(256);
+    Histogram::count(data, n, freqs);
+    vector<unsigned int> order0 = buildLengths(freqs, maxCodeLength);
+
+    // a context gets its own code if that saves more than its lengths cost
+    ContextCodes codes;
+    codes.hasOwn.assign(256, false);
+    codes.lengths.resize(256);
+    codes.headerSize = 32 + 1;
+    vector<unsigned int> sharedFreqs(256);
+    bool hasShared = false;
+    for (int c = 0; c < 256; c++) {
+        const unsigned int* contextFreqs = &counts[256 * c];
+        uint64_t total = 0;
+        for (int s = 0; s < 256; s++) total += contextFreqs[s];
+        if (total == 0) continue;
+
+        if (total >= MIN_CONTEXT_COUNT) {
+            vector<unsigned int> own = buildLengths(
+                vector<unsigned int>(contextFreqs, contextFreqs + 256),
+                maxCodeLength);
+            size_t ownSize = HCCanonical::lengthsSize(own);
+            if (codedBits(contextFreqs, own) + 8 * ownSize <
+                codedBits(contextFreqs, order0)) {
+                codes.hasOwn[c] = true;
+                codes.lengths[c] = own;
+                codes.headerSize += ownSize;
+                continue;
+            }
+        }
+        for (int s = 0; s < 256; s++) sharedFreqs[s] += contextFreqs[s];
+        hasShared = true;
+    }
+
+    // the sparse contexts share one code built from their bytes alone
+    if (hasShared) {
+        codes.shared = buildLengths(sharedFreqs, maxCodeLength);
+        codes.headerSize += HCCanonical::lengthsSize(codes.shared);
+    }
+    codes.bitCount = 0;
+    for (int c = 0; c < 256; c++) {
+        if (!codes.hasOwn[c]) codes.lengths[c] = codes.shared;
+        if (!codes.lengths[c].empty()) {
+            codes.bitCount += codedBits(&counts[256 * c], codes.lengths[c]);
+        }
+    }
+    return codes;
+}
+
+void BlockCodec::encodeOrder1(const byte* data, size_t n,
+                              const ContextCodes& codes, vector<byte>& out) {
+    out.reserve(out.size() + codes.headerSize + 4 + codes.bitCount / 8 + 1);
+
+    // bitmap of the contexts with their own code, then all the lengths
+    byte bitmap[32] = {0};
+    for (int c = 0; c < 256; c++) {
+        if (codes.hasOwn[c]) bitmap[c / 8] |= 1 << (c % 8);
+    }
+    out.insert(out.end(), bitmap, bitmap + 32);
+    out.push_back(codes.shared.empty() ? 0 : 1);
+
+    VectorOutputStream os(out);
+    if (!codes.shared.empty()) HCCanonical::writeLengths(os, codes.shared);
+    for (int c = 0; c < 256; c++) {
+        if (codes.hasOwn[c]) HCCanonical::writeLengths(os, codes.lengths[c]);
+    }
+    putInt(out, codes.bitCount, 4);
+
+    vector<vector<HCCode>> contextCodes(256);
+    for (int c = 0; c < 256; c++) {
+        if (!codes.lengths[c].empty()) {
+            contextCodes[c] = HCCanonical::codesFromLengths(codes.lengths[c]);
+        }
+    }
+
+    BitOutputStream bos(os, BLOCK_BIT_BUFFER_SIZE);
+    byte prev = 0;
+    for (size_t i = 0; i < n; i++) {
+        const HCCode& code = contextCodes[prev][data[i]];
+        bos.writeBits(code.bits, code.length);
+        prev = data[i];
+    }
+    bos.flush();
+}
+
+void BlockCodec::encodeRuns(const byte* data, size_t n, vector<byte>& runs) {
+    for (size_t i = 0; i < n;) {
+        byte symbol = data[i];
+        size_t run = 1;
+        while (i + run < n && data[i + run] == symbol) run++;
+        i += run;
+
+        runs.insert(runs.end(), min(run, (size_t)RUN_LENGTH_MIN), symbol);
+        if (run < RUN_LENGTH_MIN) continue;
+        size_t rest = run - RUN_LENGTH_MIN;
+        while (rest >= 0x80) {
+            runs.push_back((byte)(rest | 0x80));
+            rest >>= 7;
+        }
+        runs.push_back((byte)rest);
+    }
+}
+
+bool BlockCodec::decodeRuns(const vector<byte>& runs, byte* out, size_t n) {
+    size_t pos = 0, written = 0;
+    unsigned int run = 0;
+    byte prev = 0;
+    while (pos < runs.size()) {
+        byte symbol = runs[pos++];
+        if (written == n) return false;
+        out[written++] = symbol;
+        run = (run > 0 && symbol == prev) ? run + 1 : 1;
+        prev = symbol;
+        if (run < RUN_LENGTH_MIN) continue;
+
+        // the rest of the run, which has to fit in the block
+        uint64_t rest = 0;
+        for (unsigned int shift = 0;; shift += 7) {
+            if (pos == runs.size() || shift > 28) return false;
+            byte next = runs[pos++];
+            rest |= uint64_t(next & 0x7F) << shift;
+            if ((next & 0x80) == 0) break;
+        }
+        if (rest > n - written) return false;
+        memset(out + written, symbol, rest);
+        written += rest;
+        run = 0;
+    }
+    return written == n;
+}
+
+const byte* BlockCodec::storedData(const BlockHeader& header,
+                                   const byte* payload) {
+    bool isStored =
+        header.type == STORED_BLOCK && header.payloadSize == header.rawSize;
+    return isStored ? payload : nullptr;
+}
+
+bool BlockCodec::decodeBlock(const BlockHeader& header, const byte* payload,
+                             byte* out, DecoderEngine engine) {
+    if (header.type == STORED_BLOCK) {
+        if (header.payloadSize != header.rawSize) return false;
+        memcpy(out, payload, header.rawSize);
+        return true;
+    } else if (header.type == SINGLE_BLOCK) {
+        if (header.payloadSize != 1) return false;
+        memset(out, payload[0], header.rawSize);
+        return true;
+    } else if (header.type == RUN_BLOCK) {
+        return decodeRunBlock(header, payload, out, engine);
+    } else if (header.type == HUFFMAN_BLOCK) {
+        return HuffmanCoder(0, engine).decode(payload, header.payloadSize, out,
+                                              header.rawSize);
+    } else if (header.type == ANS_BLOCK) {
+        return ANSCoder().decode(payload, header.payloadSize, out,
+                                 header.rawSize);
+    } else if (header.type == INTERLEAVED_BLOCK) {
+        return decodeInterleaved(header, payload, out);
+    } else if (header.type == ORDER1_BLOCK) {
+        return decodeOrder1(header, payload, out);
+    }
+    return false;
+}
+
+bool BlockCodec::decodeRunBlock(const BlockHeader& header,
+                                const byte* payload, byte* out,
+                                DecoderEngine engine) {
+    if (header.payloadSize < 4) return false;
+
+    // run coding grows the bytes by a quarter at most, a run of
+    // RUN_LENGTH_MIN bytes gains a length byte
+    uint64_t runSize = getInt(payload, 4);
+    if (runSize > 2 * (uint64_t)header.rawSize) return false;
+    vector<byte> runs(runSize);
+    return HuffmanCoder(0, engine).decode(payload + 4, header.payloadSize - 4,
+                                          runs.data(), runSize) &&
+           decodeRuns(runs, out, header.rawSize);
+}
+
+bool BlockCodec::decodeInterleaved(const BlockHeader& header,
+                                   const byte* payload, byte* out) {
+    MemoryInputStream in(payload, header.payloadSize);
+    vector<unsigned int> lengths;
+    if (!HCCanonical::readLengths(in, lengths)) return false;
+
+    // stream count and sizes, the streams must exactly fill the payload
+    size_t pos = in.position();
+    if (pos >= header.payloadSize) return false;
+    unsigned int numStreams = payload[pos++];
+    if (numStreams < MIN_STREAMS || numStreams > MAX_STREAMS ||
+        header.payloadSize - pos < 4 * numStreams) {
+        return false;
+    }
+
+    vector<size_t> offsets(numStreams), sizes(numStreams);
+    size_t streamStart = pos + 4 * numStreams;
+    for (unsigned int s = 0; s < numStreams; s++, pos += 4) {
+        sizes[s] = getInt(payload + pos, 4);
+        if (sizes[s] > header.payloadSize - streamStart) return false;
+        offsets[s] = streamStart;
+        streamStart += sizes[s];
+    }
+    if (streamStart != header.payloadSize) return false;
+
+    HCDecodeTable table(HCCanonical::codesFromLengths(lengths));
+    table.decode(payload, offsets.data(), sizes.data(), numStreams, out,
+                 header.rawSize);
+    return true;
+}
+
+bool BlockCodec::decodeOrder1(const BlockHeader& header, const byte* payload,
+                              byte* out) {
+    if (header.payloadSize < 32 + 1) return false;
+    const byte* bitmap = payload;
+    bool hasShared = payload[32] != 0;
+
+    // one decode table per coded context, plus the shared one
+    MemoryInputStream in(payload, header.payloadSize);
+    in.ignore(32 + 1);
+    vector<HCDecodeTable> tables;
+    tables.reserve(257);
+    const HCDecodeTable* shared = nullptr;
+    vector<unsigned int> lengths;
+    if (hasShared) {
+        if (!HCCanonical::readLengths(in, lengths)) return false;
+        tables.emplace_back(HCCanonical::codesFromLengths(lengths));
+        shared = &tables.back();
+    }
+    const HCDecodeTable* byContext[256];
+    for (int c = 0; c < 256; c++) {
+        if (bitmap[c / 8] >> (c % 8) & 1) {
+            if (!HCCanonical::readLengths(in, lengths)) return false;
+            tables.emplace_back(HCCanonical::codesFromLengths(lengths),
+                                CONTEXT_TABLE_BITS);
+            byContext[c] = &tables.back();
+        } else {
+            byContext[c] = shared;
+        }
+    }
+    if (tables.empty()) return false;
+
+    // contexts that never occur may have no table, any table will do then
+    for (int c = 0; c < 256; c++) {
+        if (byContext[c] == nullptr) byContext[c] = &tables[0];
+    }
+
+    // the bit stream must fit in the rest of the payload
+    size_t streamStart = in.position() + 4;
+    if (streamStart > header.payloadSize) return false;
+    uint64_t bitCount = getInt(payload + in.position(), 4);
+    if ((bitCount + 7) / 8 > header.payloadSize - streamStart) return false;
+
+    MemoryInputStream stream(payload + streamStart,
+                             header.payloadSize - streamStart);
+    BitInputStream bis(stream, BLOCK_BIT_BUFFER_SIZE);
+    byte prev = 0;
+    for (size_t i = 0; i < header.rawSize; i++) {
+        prev = out[i] = byContext[prev]->decode(bis);
+    }
+    return true;
+}
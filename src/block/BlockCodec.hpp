@@ -0,0 +1,96 @@
+#ifndef BLOCKCODEC_HPP
+#define BLOCKCODEC_HPP
+
+#include <vector>
+#include "BlockFormat.hpp"
+#include "HuffmanCoder.hpp"
+
+using namespace std;
+
+/* Entropy coder for the blocks that use a single code */
+enum CoderChoice {
+    HUFFMAN_CODER,  // always HuffmanCoder
+    ANS_CODER,      // always ANSCoder
+    AUTO_CODER      // whichever is clearly smaller for each block
+};
+
+/** Settings used to code the blocks of a block container */
+struct BlockOptions {
+    size_t blockSize;            // number of input bytes per block
+    unsigned int maxCodeLength;  // longest codeword allowed, 0 for no limit
+    unsigned int numStreams;     // interleaved sub-streams, 1 for just one
+    bool order1;                 // try codes keyed by the previous byte
+    CoderChoice coder;           // coder of single code blocks
+
+    BlockOptions(size_t blockSize = DEFAULT_BLOCK_SIZE,
+                 unsigned int maxCodeLength = 0, unsigned int numStreams = 1,
+                 bool order1 = false, CoderChoice coder = HUFFMAN_CODER)
+        : blockSize(blockSize),
+          maxCodeLength(maxCodeLength),
+          numStreams(numStreams),
+          order1(order1),
+          coder(coder) {}
+};
+
+/** Codes single blocks of the block container. Each block gets its own
+ * code built from its own byte frequencies, a canonical Huffman code unless
+ * the options pick another coder.
+ */
+class BlockCodec {
+  private:
+    /* The codes of an ORDER1_BLOCK */
+    struct ContextCodes {
+        vector<bool> hasOwn;  // whether each context has its own code
+        vector<vector<unsigned int>> lengths;  // code used in each context
+        vector<unsigned int> shared;  // code of the other contexts, if any
+        uint64_t bitCount;            // number of bits the block codes to
+        size_t headerSize;            // bytes of the bitmap and code lengths
+    };
+
+    // pick the contexts worth their own code and build all the codes
+    static ContextCodes order1Codes(const byte* data, size_t n,
+                                    unsigned int maxCodeLength);
+
+    // append the payload of an ORDER1_BLOCK
+    static void encodeOrder1(const byte* data, size_t n,
+                             const ContextCodes& codes, vector<byte>& out);
+
+    // append the payload of an INTERLEAVED_BLOCK
+    static void encodeInterleaved(const byte* data, size_t n,
+                                  const vector<unsigned int>& lengths,
+                                  unsigned int numStreams, vector<byte>& out);
+
+    static bool decodeInterleaved(const BlockHeader& header,
+                                  const byte* payload, byte* out);
+
+    static bool decodeOrder1(const BlockHeader& header, const byte* payload,
+                             byte* out);
+
+    // append the run coding of the n bytes at data to runs
+    static void encodeRuns(const byte* data, size_t n, vector<byte>& runs);
+
+    // expand the run coded bytes back into exactly n bytes at out, false if
+    // they don't add up to that
+    static bool decodeRuns(const vector<byte>& runs, byte* out, size_t n);
+
+    static bool decodeRunBlock(const BlockHeader& header, const byte* payload,
+                               byte* out, DecoderEngine engine);
+
+  public:
+    /* Code the n bytes at data as one block and append it, header and
+     * payload, to out */
+    static void encodeBlock(const byte* data, size_t n,
+                            const BlockOptions& options, vector<byte>& out);
+
+    /* The raw bytes of a STORED_BLOCK, which can be written out straight
+     * from the payload, or nullptr for any other block */
+    static const byte* storedData(const BlockHeader& header,
+                                  const byte* payload);
+
+    /* Decode the payload of a block into header.rawSize bytes at out.
+     * Returns false if the block is damaged or of an unknown type */
+    static bool decodeBlock(const BlockHeader& header, const byte* payload,
+                            byte* out, DecoderEngine engine = AUTO_DECODER);
+};
+
+#endif  // BLOCKCODEC_HPP
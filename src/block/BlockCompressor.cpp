@@ -0,0 +1,140 @@
+#include "BlockCompressor.hpp"
+
+// blocks allowed in flight for each worker thread
+const size_t BLOCKS_PER_THREAD = 2;
+
+BlockCompressor::BlockCompressor(ostream& out, const BlockOptions& options,
+                                 unsigned int numThreads)
+    : out(out),
+      options(options),
+      numThreads(numThreads == 0 ? 1 : numThreads),
+      maxInFlight(this->numThreads * BLOCKS_PER_THREAD),
+      numAdded(0),
+      numWritten(0),
+      inputDone(false),
+      position(BLOCK_MAGIC_SIZE) {
+    out.write(BLOCK_MAGIC, BLOCK_MAGIC_SIZE);
+    if (this->numThreads == 1) return;
+
+    for (unsigned int i = 0; i < this->numThreads; i++) {
+        workers.push_back(thread(&BlockCompressor::workerLoop, this));
+    }
+    writer = thread(&BlockCompressor::writerLoop, this);
+}
+
+BlockCompressor::~BlockCompressor() { finish(); }
+
+void BlockCompressor::addData(const byte* data, size_t n) {
+    for (size_t start = 0; start < n; start += options.blockSize) {
+        Job job;
+        job.data = data + start;
+        job.n = min(options.blockSize, n - start);
+        addJob(move(job));
+    }
+}
+
+void BlockCompressor::addBlock(vector<byte>&& block) {
+    if (block.empty()) return;
+    Job job;
+    job.owned = move(block);
+    job.data = job.owned.data();
+    job.n = job.owned.size();
+    addJob(move(job));
+}
+
+void BlockCompressor::addJob(Job job) {
+    // one thread, code and write the block right away
+    if (numThreads == 1) {
+        vector<byte> block;
+        BlockCodec::encodeBlock(job.data, job.n, options, block);
+        writeBlock(block);
+        numAdded++;
+        numWritten++;
+        return;
+    }
+
+    unique_lock<mutex> guard(lock);
+    blockWritten.wait(guard,
+                      [this] { return numAdded - numWritten < maxInFlight; });
+    job.index = numAdded++;
+    jobs.push_back(move(job));
+    jobAdded.notify_one();
+}
+
+void BlockCompressor::workerLoop() {
+    while (1) {
+        Job job;
+        {
+            unique_lock<mutex> guard(lock);
+            jobAdded.wait(guard, [this] { return !jobs.empty() || inputDone; });
+            if (jobs.empty()) return;
+            job = move(jobs.front());
+            jobs.pop_front();
+        }
+
+        vector<byte> block;
+        BlockCodec::encodeBlock(job.data, job.n, options, block);
+
+        lock_guard<mutex> guard(lock);
+        coded[job.index] = move(block);
+        blockCoded.notify_all();
+    }
+}
+
+void BlockCompressor::writerLoop() {
+    while (1) {
+        vector<byte> block;
+        {
+            unique_lock<mutex> guard(lock);
+            blockCoded.wait(guard, [this] {
+                return coded.count(numWritten) != 0 ||
+                       (inputDone && numWritten == numAdded);
+            });
+            if (coded.count(numWritten) == 0) return;
+            block = move(coded[numWritten]);
+            coded.erase(numWritten);
+        }
+
+        // write outside the lock so workers can keep handing in blocks
+        writeBlock(block);
+
+        lock_guard<mutex> guard(lock);
+        numWritten++;
+        blockWritten.notify_all();
+        blockCoded.notify_all();
+    }
+}
+
+void BlockCompressor::writeBlock(const vector<byte>& block) {
+    BlockHeader header = BlockHeader::read(block.data());
+    index.push_back(BlockIndexEntry(position, header.rawSize));
+    out.write((const char*)block.data(), block.size());
+    position += block.size();
+}
+
+void BlockCompressor::finish() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (inputDone) return;
+        inputDone = true;
+        jobAdded.notify_all();
+        blockCoded.notify_all();
+    }
+
+    for (thread& worker : workers) worker.join();
+    if (writer.joinable()) writer.join();
+
+    // mark the end of the blocks
+    vector<byte> end;
+    BlockHeader().write(end);
+    uint64_t indexOffset = position + end.size();
+
+    for (const BlockIndexEntry& entry : index) {
+        putInt(end, entry.offset, 8);
+        putInt(end, entry.rawSize, 4);
+    }
+    putInt(end, indexOffset, 8);
+    putInt(end, index.size(), 4);
+    end.insert(end.end(), INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC));
+    out.write((const char*)end.data(), end.size());
+}
@@ -0,0 +1,89 @@
+#ifndef BLOCKCOMPRESSOR_HPP
+#define BLOCKCOMPRESSOR_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BlockCodec.hpp"
+
+using namespace std;
+
+/** Writes a block container to an ostream. Blocks are coded on a pool of
+ * worker threads, and a single writer thread puts the coded blocks into the
+ * ostream in input order. At most a few blocks per thread are in flight at
+ * once, so memory use doesn't grow with the input. With one thread,
+ * everything runs on the calling thread.
+ */
+class BlockCompressor {
+  private:
+    /* A block waiting to be coded */
+    struct Job {
+        size_t index;        // position of the block in the container
+        const byte* data;    // bytes of the block
+        size_t n;            // number of bytes in the block
+        vector<byte> owned;  // storage for data when the caller gave it up
+    };
+
+    ostream& out;              // where the container is written
+    BlockOptions options;      // how blocks are coded
+    unsigned int numThreads;   // number of worker threads
+    size_t maxInFlight;        // blocks added but not yet written
+
+    mutex lock;                       // guards everything below
+    condition_variable jobAdded;      // a job was queued or input ended
+    condition_variable blockCoded;    // a coded block is ready to write
+    condition_variable blockWritten;  // a block left the pipeline
+    deque<Job> jobs;                  // blocks waiting for a worker
+    map<size_t, vector<byte>> coded;  // coded blocks waiting to be written
+    size_t numAdded;                  // number of blocks added so far
+    size_t numWritten;                // number of blocks written so far
+    bool inputDone;                   // finish() was called
+
+    vector<thread> workers;  // threads coding blocks
+    thread writer;           // thread writing coded blocks in order
+
+    // only touched by whichever thread writes blocks
+    uint64_t position;              // number of bytes written to out
+    vector<BlockIndexEntry> index;  // entry for every block written
+
+    // write one coded block to out and add it to the index
+    void writeBlock(const vector<byte>& block);
+
+    // code jobs until the input is done and the queue is empty
+    void workerLoop();
+
+    // write coded blocks in order until every block is written
+    void writerLoop();
+
+    // wait for room in the pipeline, then queue the job
+    void addJob(Job job);
+
+  public:
+    /* Start a container on out, writing its magic number */
+    BlockCompressor(ostream& out, const BlockOptions& options,
+                    unsigned int numThreads);
+
+    /* Waits for all blocks, see finish() */
+    ~BlockCompressor();
+
+    // the threads hold a pointer to this object
+    BlockCompressor(const BlockCompressor&) = delete;
+    BlockCompressor& operator=(const BlockCompressor&) = delete;
+
+    /* Split n bytes into blocks and queue them. data must stay valid until
+     * finish() returns */
+    void addData(const byte* data, size_t n);
+
+    /* Queue one block, taking over its bytes */
+    void addBlock(vector<byte>&& block);
+
+    /* Wait for every queued block to be written, then end the container
+     * and write the block index */
+    void finish();
+};
+
+#endif  // BLOCKCOMPRESSOR_HPP
@@ -0,0 +1,124 @@
+#include "BlockDecompressor.hpp"
+
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+bool BlockDecompressor::readIndex(const byte* data, size_t size,
+                                  vector<BlockIndexEntry>& index) {
+    index.clear();
+    if (size < BLOCK_MAGIC_SIZE + BLOCK_HEADER_SIZE + INDEX_TRAILER_SIZE ||
+        memcmp(data + size - sizeof(INDEX_MAGIC), INDEX_MAGIC,
+               sizeof(INDEX_MAGIC)) != 0) {
+        return false;
+    }
+
+    // the trailer gives where the index starts and how long it is
+    const byte* trailer = data + size - INDEX_TRAILER_SIZE;
+    uint64_t indexOffset = getInt(trailer, 8);
+    uint64_t numBlocks = getInt(trailer + 8, 4);
+    size_t indexSize = size - INDEX_TRAILER_SIZE;
+    if (indexOffset < BLOCK_MAGIC_SIZE + BLOCK_HEADER_SIZE ||
+        indexOffset > indexSize ||
+        (indexSize - indexOffset) != numBlocks * INDEX_ENTRY_SIZE) {
+        return false;
+    }
+
+    // every entry must point at a block that fits before the next one, and
+    // the last block must be followed by the end block
+    vector<BlockIndexEntry> entries;
+    uint64_t blockEnd = BLOCK_MAGIC_SIZE;
+    uint64_t rawOffset = 0;
+    const byte* entry = data + indexOffset;
+    for (uint64_t i = 0; i < numBlocks; i++, entry += INDEX_ENTRY_SIZE) {
+        uint64_t offset = getInt(entry, 8);
+        uint32_t rawSize = getInt(entry + 8, 4);
+        if (offset != blockEnd ||
+            indexOffset - offset < 2 * BLOCK_HEADER_SIZE) {
+            return false;
+        }
+
+        BlockHeader header = BlockHeader::read(data + offset);
+        if (header.type == END_BLOCK || header.rawSize != rawSize ||
+            rawSize > MAX_BLOCK_SIZE ||
+            header.payloadSize >
+                indexOffset - offset - 2 * BLOCK_HEADER_SIZE) {
+            return false;
+        }
+
+        entries.push_back(BlockIndexEntry(offset, rawSize, rawOffset));
+        blockEnd = offset + BLOCK_HEADER_SIZE + header.payloadSize;
+        rawOffset += rawSize;
+    }
+
+    if (blockEnd + BLOCK_HEADER_SIZE != indexOffset ||
+        BlockHeader::read(data + blockEnd).type != END_BLOCK) {
+        return false;
+    }
+    index.swap(entries);
+    return true;
+}
+
+uint64_t BlockDecompressor::rawSize(const vector<BlockIndexEntry>& index) {
+    if (index.empty()) return 0;
+    return index.back().rawOffset + index.back().rawSize;
+}
+
+/* Write all n bytes at data to fd at offset, pwrite() may write less */
+static bool writeAt(int fd, const byte* data, size_t n, uint64_t offset) {
+    while (n > 0) {
+        ssize_t written = pwrite(fd, data, n, offset);
+        if (written <= 0) return false;
+        data += written;
+        n -= written;
+        offset += written;
+    }
+    return true;
+}
+
+vector<size_t> BlockDecompressor::decodeToFile(
+    const byte* data, const vector<BlockIndexEntry>& index, int fd,
+    unsigned int numThreads, DecoderEngine engine) {
+    atomic<size_t> nextBlock(0);
+    mutex lock;
+    vector<size_t> damaged;
+
+    // each thread takes the next block not yet taken until none are left
+    auto decodeBlocks = [&]() {
+        vector<byte> block;
+        for (size_t i = nextBlock++; i < index.size(); i = nextBlock++) {
+            const BlockIndexEntry& entry = index[i];
+            BlockHeader header = BlockHeader::read(data + entry.offset);
+            const byte* payload = data + entry.offset + BLOCK_HEADER_SIZE;
+
+            // stored bytes go to the file straight from the input
+            const byte* raw = BlockCodec::storedData(header, payload);
+            bool isWritten;
+            if (raw != nullptr) {
+                isWritten = writeAt(fd, raw, entry.rawSize, entry.rawOffset);
+            } else {
+                block.resize(entry.rawSize);
+                isWritten = BlockCodec::decodeBlock(header, payload,
+                                                    block.data(), engine) &&
+                            writeAt(fd, block.data(), block.size(),
+                                    entry.rawOffset);
+            }
+            if (!isWritten) {
+                lock_guard<mutex> guard(lock);
+                damaged.push_back(i);
+            }
+        }
+    };
+
+    if (numThreads == 0) numThreads = 1;
+    vector<thread> workers;
+    for (unsigned int i = 1; i < numThreads; i++) {
+        workers.push_back(thread(decodeBlocks));
+    }
+    decodeBlocks();
+    for (thread& worker : workers) worker.join();
+
+    sort(damaged.begin(), damaged.end());
+    return damaged;
+}
@@ -0,0 +1,35 @@
+#ifndef BLOCKDECOMPRESSOR_HPP
+#define BLOCKDECOMPRESSOR_HPP
+
+#include <vector>
+#include "BlockCodec.hpp"
+
+using namespace std;
+
+/** Decodes the blocks of a container that has a block index. The index
+ * gives the place of every block in the output, so blocks are decoded on
+ * several threads, each writing its blocks straight to its place in the
+ * output file with pwrite().
+ */
+class BlockDecompressor {
+  public:
+    /* Read the block index of the size byte container at data. Returns
+     * false if the container has no index or the index doesn't match its
+     * blocks */
+    static bool readIndex(const byte* data, size_t size,
+                          vector<BlockIndexEntry>& index);
+
+    /* Number of bytes the blocks in index decode to */
+    static uint64_t rawSize(const vector<BlockIndexEntry>& index);
+
+    /* Decode every block in index on numThreads threads and write it to its
+     * place in the file open for writing as fd, which must already be
+     * rawSize(index) bytes of 0s. Returns the numbers of the damaged blocks,
+     * which are left as 0s */
+    static vector<size_t> decodeToFile(const byte* data,
+                                       const vector<BlockIndexEntry>& index,
+                                       int fd, unsigned int numThreads,
+                                       DecoderEngine engine = AUTO_DECODER);
+};
+
+#endif  // BLOCKDECOMPRESSOR_HPP
@@ -0,0 +1,163 @@
+#ifndef BLOCKFORMAT_HPP
+#define BLOCKFORMAT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/* The block container format. All integers are little-endian.
+ *
+ *   file    = magic, block*, end block, [index, trailer]
+ *   block   = type (1 byte), raw size (4 bytes), payload size (4 bytes),
+ *             payload
+ *   index   = one entry per block: block offset (8 bytes), raw size
+ *             (4 bytes)
+ *   trailer = index offset (8 bytes), block count (4 bytes), index magic
+ *
+ * Every block is coded on its own, so blocks can be written as soon as they
+ * are read, coded in parallel, and a damaged block can be skipped using its
+ * payload size. The end block has type END_BLOCK and empty sizes.
+ *
+ * The index lets a reader find every block, and where its bytes go in the
+ * output, without walking the blocks first, so blocks can be decoded in
+ * parallel. Readers walking the blocks stop at the end block and never see
+ * it, and a file without one is still a valid container.
+ *
+ * Payload of a HUFFMAN_BLOCK:
+ *   code lengths (HCCanonical layout), bit count (4 bytes), bit stream
+ *
+ * Payload of an INTERLEAVED_BLOCK:
+ *   code lengths (HCCanonical layout), stream count k (1 byte), byte size of
+ *   each stream (4 bytes each), the k bit streams one after another
+ * Symbol i of the block is in stream i % k, so k decoders can run side by
+ * side. Every stream is padded to a whole byte.
+ *
+ * Payload of an ORDER1_BLOCK:
+ *   context bitmap (32 bytes), shared flag (1 byte), [shared code lengths],
+ *   code lengths of every context in the bitmap, bit count (4 bytes),
+ *   bit stream
+ * Every byte is coded with the code of its context, the byte before it (0
+ * for the first byte). Contexts set in the bitmap have their own code, the
+ * rest share one code, which is only there if the flag is 1.
+ *
+ * Payload of an ANS_BLOCK: see ANSCoder
+ *
+ * Payload of a STORED_BLOCK:
+ *   the raw bytes, payload size equals raw size
+ * Used for blocks that coding would barely shrink.
+ *
+ * Payload of a SINGLE_BLOCK:
+ *   the byte (1 byte)
+ * Used for blocks that are one byte repeated, which decode to a memset.
+ *
+ * Payload of a RUN_BLOCK:
+ *   size of the run coded bytes (4 bytes), HUFFMAN_BLOCK payload of them
+ * A run of RUN_LENGTH_MIN or more equal bytes is coded as RUN_LENGTH_MIN of
+ * them and the number of bytes left in the run, 7 bits per byte with the
+ * high bit set on all but the last. Shorter runs are coded as they are.
+ */
+
+/* Magic number at the start of a block container file */
+const char BLOCK_MAGIC[4] = {'H', 'C', 'B', '1'};
+const size_t BLOCK_MAGIC_SIZE = sizeof(BLOCK_MAGIC);
+
+/* Magic number at the very end of a container that has a block index */
+const char INDEX_MAGIC[4] = {'H', 'C', 'B', 'I'};
+
+/* Number of bytes in one block index entry and in the index trailer */
+const size_t INDEX_ENTRY_SIZE = 12;
+const size_t INDEX_TRAILER_SIZE = 12 + sizeof(INDEX_MAGIC);
+
+/* Block types */
+const byte END_BLOCK = 0;
+const byte HUFFMAN_BLOCK = 1;
+const byte INTERLEAVED_BLOCK = 2;
+const byte ORDER1_BLOCK = 3;
+const byte ANS_BLOCK = 4;
+const byte STORED_BLOCK = 5;
+const byte SINGLE_BLOCK = 6;
+const byte RUN_BLOCK = 7;
+
+/* Number of equal bytes after which a RUN_BLOCK codes the run length */
+const unsigned int RUN_LENGTH_MIN = 4;
+
+/* Range of sub-stream counts of an INTERLEAVED_BLOCK */
+const unsigned int MIN_STREAMS = 2;
+const unsigned int MAX_STREAMS = 16;
+const unsigned int DEFAULT_STREAMS = 4;
+
+/* Number of bytes in a block header */
+const size_t BLOCK_HEADER_SIZE = 9;
+
+/* Range of block sizes the container accepts */
+const size_t MIN_BLOCK_SIZE = 1 << 12;
+const size_t MAX_BLOCK_SIZE = 1 << 24;
+const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+/* Number of bytes the bit streams of a payload buffer at a time */
+const size_t BLOCK_BIT_BUFFER_SIZE = 1 << 16;
+
+/* Largest payload any block can have. Codewords are at most 57 bits, so a
+ * payload is never more than 8 bytes per raw byte */
+const size_t MAX_PAYLOAD_SIZE = 8 * MAX_BLOCK_SIZE;
+
+/* Append the low numBytes bytes of value, least significant byte first */
+inline void putInt(vector<byte>& out, uint64_t value, int numBytes) {
+    for (int i = 0; i < numBytes; i++) out.push_back((byte)(value >> (8 * i)));
+}
+
+/* Read a numBytes byte integer written by putInt */
+inline uint64_t getInt(const byte* in, int numBytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < numBytes; i++) value |= uint64_t(in[i]) << (8 * i);
+    return value;
+}
+
+/** The fixed-size header in front of every block */
+struct BlockHeader {
+    byte type;             // how the payload is coded
+    uint32_t rawSize;      // number of bytes the block decodes to
+    uint32_t payloadSize;  // number of payload bytes after the header
+
+    BlockHeader(byte type = END_BLOCK, uint32_t rawSize = 0,
+                uint32_t payloadSize = 0)
+        : type(type), rawSize(rawSize), payloadSize(payloadSize) {}
+
+    /* Append the header to out */
+    void write(vector<byte>& out) const {
+        out.push_back(type);
+        putInt(out, rawSize, 4);
+        putInt(out, payloadSize, 4);
+    }
+
+    /* Overwrite the header already in out at the given index */
+    void write(vector<byte>& out, size_t index) const {
+        vector<byte> bytes;
+        write(bytes);
+        copy(bytes.begin(), bytes.end(), out.begin() + index);
+    }
+
+    /* Read a header from BLOCK_HEADER_SIZE bytes at in */
+    static BlockHeader read(const byte* in) {
+        return BlockHeader(in[0], getInt(in + 1, 4), getInt(in + 5, 4));
+    }
+};
+
+/** Where one block is in a container and where its bytes go when decoded */
+struct BlockIndexEntry {
+    uint64_t offset;     // offset of the block header in the container
+    uint32_t rawSize;    // number of bytes the block decodes to
+    uint64_t rawOffset;  // offset of the decoded bytes in the output (not
+                         // stored, it is the sum of the raw sizes before it)
+
+    BlockIndexEntry(uint64_t offset = 0, uint32_t rawSize = 0,
+                    uint64_t rawOffset = 0)
+        : offset(offset), rawSize(rawSize), rawOffset(rawOffset) {}
+};
+
+#endif  // BLOCKFORMAT_HPP
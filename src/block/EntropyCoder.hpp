@@ -0,0 +1,39 @@
+#ifndef ENTROPYCODER_HPP
+#define ENTROPYCODER_HPP
+
+#include <cstdint>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** An entropy coder for the payload of a block. The coder is built from
+ * the byte histogram of a block, can tell about how big the payload will
+ * be before writing it, and writes and reads payloads that carry their own
+ * code table, so a block can be coded with whichever coder does best.
+ */
+class EntropyCoder {
+  public:
+    virtual ~EntropyCoder() {}
+
+    /* Build the code for a block with the given 256 byte frequencies */
+    virtual void build(const vector<unsigned int>& freqs) = 0;
+
+    /* Number of bytes encode() appends for the block build() was given.
+     * Exact if the size only depends on the histogram, otherwise (as for
+     * ANS, where it depends on the order of the bytes) an estimate */
+    virtual uint64_t encodedSize() const = 0;
+
+    /* Append the code table and the coded n bytes at data to out. Every
+     * byte must have a frequency */
+    virtual void encode(const byte* data, size_t n,
+                        vector<byte>& out) const = 0;
+
+    /* Decode n bytes from a payload of size bytes written by encode().
+     * Returns false if the payload is damaged */
+    virtual bool decode(const byte* payload, size_t size, byte* out,
+                        size_t n) const = 0;
+};
+
+#endif  // ENTROPYCODER_HPP
@@ -0,0 +1,88 @@
+#include "HuffmanCoder.hpp"
+
+#include "BitInputStream.hpp"
+#include "BitOutputStream.hpp"
+#include "BlockFormat.hpp"
+#include "HCCanonical.hpp"
+#include "HCDecodeTable.hpp"
+#include "HCFSMDecodeTable.hpp"
+#include "HCMultiDecodeTable.hpp"
+#include "HCTree.hpp"
+#include "MemoryStream.hpp"
+
+void HuffmanCoder::build(const vector<unsigned int>& freqs) {
+    this->freqs = freqs;
+    HCTree tree;
+    tree.build(freqs, maxCodeLength);
+    lengths = HCCanonical::codeLengths(tree.getCodes());
+}
+
+uint64_t HuffmanCoder::encodedSize() const {
+    uint64_t bitCount = 0;
+    for (int i = 0; i < 256; i++) bitCount += (uint64_t)freqs[i] * lengths[i];
+    return HCCanonical::lengthsSize(lengths) + 4 + (bitCount + 7) / 8;
+}
+
+void HuffmanCoder::encode(const byte* data, size_t n,
+                          vector<byte>& out) const {
+    vector<HCCode> codes = HCCanonical::codesFromLengths(lengths);
+
+    // the exact size of the bit stream is known before encoding
+    uint64_t bitCount = 0;
+    for (int i = 0; i < 256; i++) bitCount += (uint64_t)freqs[i] * lengths[i];
+    out.reserve(out.size() + 2 * 256 + 4 + bitCount / 8 + 1);
+
+    VectorOutputStream os(out);
+    HCCanonical::writeLengths(os, lengths);
+    putInt(out, bitCount, 4);
+
+    BitOutputStream bos(os, BLOCK_BIT_BUFFER_SIZE);
+    for (size_t i = 0; i < n; i++) {
+        bos.writeBits(codes[data[i]].bits, codes[data[i]].length);
+    }
+    bos.flush();
+}
+
+bool HuffmanCoder::decode(const byte* payload, size_t size, byte* out,
+                          size_t n) const {
+    MemoryInputStream in(payload, size);
+    vector<unsigned int> lengths;
+    if (!HCCanonical::readLengths(in, lengths)) return false;
+
+    // the bit stream must fit in the rest of the payload
+    size_t streamStart = in.position() + 4;
+    if (streamStart > size) return false;
+    uint64_t bitCount = getInt(payload + in.position(), 4);
+    if ((bitCount + 7) / 8 > size - streamStart) return false;
+
+    vector<HCCode> codes = HCCanonical::codesFromLengths(lengths);
+    const byte* streamData = payload + streamStart;
+    size_t streamSize = size - streamStart;
+
+    // short codewords, several of them per lookup
+    DecoderEngine engine = this->engine;
+    if (engine == AUTO_DECODER) {
+        bool isShort =
+            n > 0 && HCMultiDecodeTable::paysOff((double)bitCount / n);
+        engine = isShort ? MULTI_DECODER : TABLE_DECODER;
+    }
+
+    // a whole input byte per lookup, unless the code has too many states
+    if (engine == FSM_DECODER) {
+        HCFSMDecodeTable fsm(codes);
+        if (fsm.isValid()) {
+            fsm.decode(streamData, streamSize, out, n);
+            return true;
+        }
+        engine = TABLE_DECODER;
+    }
+
+    MemoryInputStream stream(streamData, streamSize);
+    BitInputStream bis(stream, BLOCK_BIT_BUFFER_SIZE);
+    if (engine == MULTI_DECODER) {
+        HCMultiDecodeTable(codes).decode(bis, out, n);
+    } else {
+        HCDecodeTable(codes).decode(bis, out, n);
+    }
+    return true;
+}
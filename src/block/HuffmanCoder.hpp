@@ -0,0 +1,45 @@
+#ifndef HUFFMANCODER_HPP
+#define HUFFMANCODER_HPP
+
+#include <vector>
+#include "EntropyCoder.hpp"
+
+using namespace std;
+
+/* Ways to decode the bit stream of a HUFFMAN_BLOCK */
+enum DecoderEngine {
+    AUTO_DECODER,   // MULTI_DECODER for short codewords, else TABLE_DECODER
+    TABLE_DECODER,  // HCDecodeTable, one symbol per lookup
+    MULTI_DECODER,  // HCMultiDecodeTable, several symbols per lookup
+    FSM_DECODER     // HCFSMDecodeTable, one input byte per lookup
+};
+
+/** The canonical Huffman coder of a HUFFMAN_BLOCK. The payload is the code
+ * lengths, the number of bits in the bit stream, and the bit stream.
+ */
+class HuffmanCoder : public EntropyCoder {
+  private:
+    unsigned int maxCodeLength;  // longest codeword allowed, 0 for no limit
+    DecoderEngine engine;        // how to decode the bit stream
+    vector<unsigned int> freqs;  // histogram the code was built for
+    vector<unsigned int> lengths;  // codeword length of every symbol
+
+  public:
+    explicit HuffmanCoder(unsigned int maxCodeLength = 0,
+                          DecoderEngine engine = AUTO_DECODER)
+        : maxCodeLength(maxCodeLength), engine(engine) {}
+
+    void build(const vector<unsigned int>& freqs) override;
+
+    /* Codeword length of every symbol, once built */
+    const vector<unsigned int>& getLengths() const { return lengths; }
+
+    uint64_t encodedSize() const override;
+
+    void encode(const byte* data, size_t n, vector<byte>& out) const override;
+
+    bool decode(const byte* payload, size_t size, byte* out,
+                size_t n) const override;
+};
+
+#endif  // HUFFMANCODER_HPP
@@ -0,0 +1,73 @@
+#ifndef MEMORYSTREAM_HPP
+#define MEMORYSTREAM_HPP
+
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** A streambuf that reads straight out of a byte array, without copying it
+ * into a string first like istringstream does */
+class MemoryInputBuf : public streambuf {
+  public:
+    MemoryInputBuf(const byte* data, size_t n) {
+        char* begin = (char*)data;
+        setg(begin, begin, begin + n);
+    }
+
+    /* Number of bytes read so far */
+    size_t position() const { return gptr() - eback(); }
+};
+
+/** An istream over a byte array, so BitInputStream can read from memory */
+class MemoryInputStream : public istream {
+  private:
+    MemoryInputBuf buf;  // streambuf over the byte array
+
+  public:
+    MemoryInputStream(const byte* data, size_t n)
+        : istream(nullptr), buf(data, n) {
+        rdbuf(&buf);
+    }
+
+    /* Number of bytes read so far */
+    size_t position() const { return buf.position(); }
+};
+
+/** A streambuf that appends everything written to it to a byte vector */
+class VectorOutputBuf : public streambuf {
+  private:
+    vector<byte>& out;  // vector to append to
+
+  protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) out.push_back((byte)c);
+        return c;
+    }
+
+    streamsize xsputn(const char* s, streamsize n) override {
+        out.insert(out.end(), (const byte*)s, (const byte*)s + n);
+        return n;
+    }
+
+  public:
+    explicit VectorOutputBuf(vector<byte>& out) : out(out) {}
+};
+
+/** An ostream that appends to a byte vector, so BitOutputStream can write to
+ * memory */
+class VectorOutputStream : public ostream {
+  private:
+    VectorOutputBuf buf;  // streambuf appending to the vector
+
+  public:
+    explicit VectorOutputStream(vector<byte>& out)
+        : ostream(nullptr), buf(out) {
+        rdbuf(&buf);
+    }
+};
+
+#endif  // MEMORYSTREAM_HPP
@@ -7,29 +7,36 @@
 #include <fstream>
 #include <iostream>
 
+#include "BlockCodec.hpp"
+#include "BlockCompressor.hpp"
 #include "FileUtils.hpp"
+#include "HCAdaptiveTree.hpp"
+#include "HCCanonical.hpp"
+#include "HCDecodeTable.hpp"
 #include "HCNode.hpp"
 #include "HCTree.hpp"
+#include "Histogram.hpp"
+#include "InputBuffer.hpp"
+#include "RCModel.hpp"
+#include "TunstallCode.hpp"
+
+/* Number of encoded bytes collected before each write to the output file */
+const size_t BIT_BUFFER_SIZE = 1 << 16;
 
 /* TODO: add pseudo compression with ascii encoding and naive header
  * (checkpoint) */
 void pseudoCompression(const string& inFileName, const string& outFileName) {
-    ifstream in(inFileName, ios::binary);
+    InputBuffer in(inFileName);
     ofstream out;
-    unsigned char c;
     unsigned char newLine = '\n';
 
     // check if file opened successfully
-    if (in.is_open()) {
+    if (in.isOpen()) {
         // construct huffman tree
         HCTree tree;
         vector<unsigned int> freqs(256);
         cout << "Reading through file" << endl;
-        while (1) {
-            c = in.get();
-            if (in.eof()) break;
-            freqs[c]++;
-        }
+        Histogram::count(in.getData(), in.size(), freqs);
 
         cout << "Building Huffman Tree" << endl;
         tree.build(freqs);
@@ -42,43 +49,29 @@ void pseudoCompression(const string& inFileName, const string& outFileName) {
             out.write(str.c_str(), str.length());
             out.write((char*)&newLine, sizeof(newLine));
         }
-        // reset "get" pointer to beginning of infile
-        in.clear();
-        in.seekg(0, ios::beg);
 
-        // start compression
+        // start compression, a second pass over the same memory
         cout << "Compressing" << endl;
-        while (1) {
-            c = in.get();
-            if (in.eof()) break;
-            tree.encode(c, out);
-        }
+        const byte* data = in.getData();
+        for (size_t i = 0; i < in.size(); i++) tree.encode(data[i], out);
 
         cout << "Done" << endl;
-        in.close();
         out.close();
     }
 }
 
 /* TODO: True compression with bitwise i/o and small header (final) */
 void trueCompression(const string& inFileName, const string& outFileName) {
-    ifstream in(inFileName, ios::binary);
+    InputBuffer in(inFileName);
     ofstream out;
-    unsigned char c;
-    int totalBytes = 0;
 
     // check if file opened successfully
-    if (in.is_open()) {
+    if (in.isOpen()) {
         // construct huffman tree (char -> freqs vector)
         HCTree tree;
         vector<unsigned int> freqs(256);
         cout << "Reading through file" << endl;
-        while (1) {
-            c = in.get();
-            if (in.eof()) break;
-            totalBytes++;
-            freqs[c]++;
-        }
+        Histogram::count(in.getData(), in.size(), freqs);
 
         cout << "Building Huffman Tree" << endl;
         tree.build(freqs);
@@ -89,18 +82,15 @@ void trueCompression(const string& inFileName, const string& outFileName) {
         for (int i = 0; i < freqs.size(); i++) {
             out << " " << freqs[i];
         }
-        // reset "get" pointer to beginning of infile
-        in.clear();
-        in.seekg(0, ios::beg);
 
-        // start compression bit by bit(char -> int/bit)
-        BitOutputStream bos(out);
+        // start compression bit by bit(char -> int/bit), a second pass over
+        // the same memory
+        BitOutputStream bos(out, BIT_BUFFER_SIZE);
         cout << "Compressing" << endl;
-        for (int i = 0; i < totalBytes; i++) {
-            c = in.get();
-            if (in.eof()) break;
+        const byte* data = in.getData();
+        for (size_t i = 0; i < in.size(); i++) {
             // encode given 8-bit char
-            tree.encode(c, bos);
+            tree.encode(data[i], bos);
         }
         cout << "Done compressing, now doing padded 0s" << endl;
 
@@ -110,22 +100,223 @@ void trueCompression(const string& inFileName, const string& outFileName) {
         cout << "Padded 0s: " << paddedZeros << endl;
 
         cout << "Done" << endl;
-        in.close();
         out.close();
     }
 }
 
+/* Compression with canonical Huffman codes, where the header only holds the
+ * code length of each symbol and the number of encoded symbols. A non-zero
+ * maxCodeLength caps the codeword length */
+void canonicalCompression(const string& inFileName, const string& outFileName,
+                          unsigned int maxCodeLength) {
+    InputBuffer in(inFileName);
+    ofstream out;
+
+    // check if file opened successfully
+    if (in.isOpen()) {
+        // construct huffman tree (char -> freqs vector)
+        HCTree tree;
+        vector<unsigned int> freqs(256);
+        cout << "Reading through file" << endl;
+        Histogram::count(in.getData(), in.size(), freqs);
+
+        // only the code lengths are kept from the tree, the codewords
+        // themselves are reassigned in canonical order
+        cout << "Building Huffman Tree" << endl;
+        tree.build(freqs, maxCodeLength);
+        vector<unsigned int> lengths =
+            HCCanonical::codeLengths(tree.getCodes());
+        vector<HCCode> codes = HCCanonical::codesFromLengths(lengths);
+        cout << "Done" << endl;
+
+        // build outfile header (code lengths, then number of symbols)
+        out.open(outFileName, ios::binary);
+        HCCanonical::writeLengths(out, lengths);
+        FileUtils::writeInt(out, in.size(), 8);
+
+        BitOutputStream bos(out, BIT_BUFFER_SIZE);
+        cout << "Compressing" << endl;
+        const byte* data = in.getData();
+        for (size_t i = 0; i < in.size(); i++) {
+            bos.writeBits(codes[data[i]].bits, codes[data[i]].length);
+        }
+
+        // the symbol count in the header tells the decoder where to stop,
+        // so the padded 0s don't need to be recorded
+        bos.flush();
+
+        cout << "Done" << endl;
+        out.close();
+    }
+}
+
+/* Compression into the block container, where every block of the input is
+ * coded on its own with a canonical Huffman code built for that block */
+void blockCompression(const string& inFileName, const string& outFileName,
+                      const BlockOptions& blockOptions,
+                      unsigned int numThreads) {
+    InputBuffer in(inFileName);
+    ofstream out;
+
+    // check if file opened successfully
+    if (in.isOpen()) {
+        out.open(outFileName, ios::binary);
+
+        cout << "Compressing blocks" << endl;
+        BlockCompressor compressor(out, blockOptions, numThreads);
+        compressor.addData(in.getData(), in.size());
+        compressor.finish();
+
+        cout << "Done" << endl;
+        out.close();
+    }
+}
+
+/* Compress a stream into a block container, reading one block at a time.
+ * Only the blocks being coded are held in memory, so in can be a pipe of any
+ * length */
+void streamCompression(istream& in, ostream& out,
+                       const BlockOptions& blockOptions,
+                       unsigned int numThreads) {
+    cerr << "Compressing blocks from stream" << endl;
+    BlockCompressor compressor(out, blockOptions, numThreads);
+    while (in) {
+        vector<byte> block(blockOptions.blockSize);
+        in.read((char*)block.data(), block.size());
+        block.resize(in.gcount());
+        compressor.addBlock(move(block));
+    }
+    compressor.finish();
+    cerr << "Done" << endl;
+}
+
+/* Compress a stream in one pass with a dynamic Huffman tree. There is no
+ * header, every byte is coded as soon as it is read, and the end of the
+ * data is marked by END_SYMBOL. Coded bytes go out whenever the input has
+ * to be waited for */
+void adaptiveCompression(istream& in, ostream& out) {
+    cerr << "Compressing with adaptive Huffman" << endl;
+    HCAdaptiveTree::encodeStream(in, out);
+    cerr << "Done" << endl;
+}
+
+/* Compress the n bytes at data with a Tunstall code, every codeword the
+ * same width so it decodes with one table copy. The header holds the
+ * normalized frequencies the code is built from and the number of bytes */
+void tunstallCompression(const byte* data, size_t n, ostream& out,
+                         unsigned int codeBits) {
+    cerr << "Compressing with a Tunstall code" << endl;
+    vector<unsigned int> freqs(256);
+    Histogram::count(data, n, freqs);
+    TunstallCode code(freqs, codeBits);
+
+    code.writeHeader(out);
+    FileUtils::writeInt(out, n, 8);
+    BitOutputStream bos(out, BIT_BUFFER_SIZE);
+    code.encode(data, n, bos);
+    bos.flush();
+    cerr << "Done" << endl;
+}
+
+/* Compress the n bytes at data with a range coder and adaptive byte
+ * frequencies, order 1 keyed by the previous byte. The model starts from a
+ * seed made from the histogram of the data, which goes in the header with
+ * the number of bytes */
+void rangeCompression(const byte* data, size_t n, ostream& out,
+                      unsigned int order) {
+    cerr << "Compressing with a range coder" << endl;
+    vector<unsigned int> freqs(256);
+    Histogram::count(data, n, freqs);
+    vector<unsigned int> seed = RCModel::makeSeed(freqs);
+
+    RCModel::writeHeader(out, seed, order);
+    FileUtils::writeInt(out, n, 8);
+    RCModel model(seed, order);
+    RangeEncoder encoder(out, BIT_BUFFER_SIZE);
+    for (size_t i = 0; i < n; i++) model.encode(data[i], encoder);
+    encoder.flush();
+    cerr << "Done" << endl;
+}
+
+/* Look up the block coder with the given name */
+bool parseCoder(const string& name, CoderChoice& coder) {
+    if (name == "huffman") {
+        coder = HUFFMAN_CODER;
+    } else if (name == "ans") {
+        coder = ANS_CODER;
+    } else if (name == "auto") {
+        coder = AUTO_CODER;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 /* Main program that runs the compression */
 int main(int argc, char* argv[]) {
     cxxopts::Options options(argv[0],
                              "Compresses files using Huffman Encoding");
-    options.positional_help("./path_to_input_file ./path_to_output_file");
+    options.positional_help(
+        "./path_to_input_file ./path_to_output_file (- for stdin/stdout "
+        "streams a block container)");
 
     bool isAsciiOutput = false;
+    bool isCanonical = false;
+    bool isBlock = false;
+    size_t blockSize = DEFAULT_BLOCK_SIZE;
+    unsigned int maxCodeLength = 0;
+    unsigned int numThreads = 0;
+    bool isInterleaved = false;
+    unsigned int numStreams = DEFAULT_STREAMS;
+    bool isOrder1 = false;
+    string coderName = "huffman";
+    string engineName = "huffman";
+    unsigned int codeBits = TunstallCode::DEFAULT_CODE_BITS;
     string inFileName, outFileName;
     options.allow_unrecognised_options().add_options()(
         "ascii", "Write output in ascii mode instead of bit stream",
         cxxopts::value<bool>(isAsciiOutput))(
+        "canonical", "Use canonical codes with a code length header",
+        cxxopts::value<bool>(isCanonical))(
+        "block", "Write a block container with a code for every block",
+        cxxopts::value<bool>(isBlock))(
+        "block-size", "Number of input bytes per block in block mode",
+        cxxopts::value<size_t>(blockSize))(
+        "max-code-length",
+        "Longest codeword allowed in canonical and block mode (0 for no "
+        "limit)",
+        cxxopts::value<unsigned int>(maxCodeLength))(
+        "threads",
+        "Number of threads coding blocks at once (implies --block)",
+        cxxopts::value<unsigned int>(numThreads))(
+        "interleaved",
+        "Split every block into interleaved sub-streams that decode side by "
+        "side (implies --block)",
+        cxxopts::value<bool>(isInterleaved))(
+        "streams",
+        "Number of sub-streams per block in interleaved mode (8 decodes "
+        "with AVX2)",
+        cxxopts::value<unsigned int>(numStreams))(
+        "order1",
+        "Code every byte with a code picked by the byte before it, where "
+        "that is smaller (implies --block, not interleaved)",
+        cxxopts::value<bool>(isOrder1))(
+        "coder",
+        "Entropy coder of the blocks: huffman, ans (table-based ANS, "
+        "fractional bits per byte) or auto (the clearly smaller one for "
+        "each block); implies --block",
+        cxxopts::value<string>(coderName))(
+        "engine",
+        "Coding engine: huffman (static codes), adaptive (dynamic "
+        "Huffman in one pass, no header), tunstall (fixed width "
+        "codewords for fast decoding) or range (range coder with adaptive "
+        "order-0 or, with --order1, order-1 frequencies); tunstall and "
+        "range need a file input, not stdin",
+        cxxopts::value<string>(engineName))(
+        "code-bits",
+        "Width of every codeword with the tunstall engine (8 to 16), wider "
+        "codewords cover longer strings",
+        cxxopts::value<unsigned int>(codeBits))(
         "input", "", cxxopts::value<string>(inFileName))(
         "output", "", cxxopts::value<string>(outFileName))(
         "h,help", "Print help and exit");
@@ -133,9 +324,92 @@ int main(int argc, char* argv[]) {
     options.parse_positional({"input", "output"});
     auto userOptions = options.parse(argc, argv);
 
-    if (userOptions.count("help") || !FileUtils::isValidFile(inFileName) ||
-        outFileName.empty()) {
-        cout << options.help({""}) << std::endl;
+    bool isStream = FileUtils::isStdStream(inFileName) ||
+                    FileUtils::isStdStream(outFileName);
+    if (userOptions.count("help") || outFileName.empty() ||
+        (!FileUtils::isStdStream(inFileName) &&
+         !FileUtils::isValidFile(inFileName))) {
+        // keep the help text out of a stream being piped on
+        (isStream ? cerr : cout) << options.help({""}) << std::endl;
+        return 0;
+    }
+
+    bool isAdaptive = engineName == "adaptive";
+    bool isTunstall = engineName == "tunstall";
+    bool isRange = engineName == "range";
+    if (!isAdaptive && !isTunstall && !isRange && engineName != "huffman") {
+        cerr << "Unknown engine " << engineName << ". Please try again.\n";
+        return 0;
+    }
+    CoderChoice coder;
+    if (!parseCoder(coderName, coder)) {
+        cerr << "Unknown coder " << coderName << ". Please try again.\n";
+        return 0;
+    }
+
+    // keep the block size and stream count in the range the container accepts
+    blockSize = max(MIN_BLOCK_SIZE, min(blockSize, MAX_BLOCK_SIZE));
+    numStreams = max(MIN_STREAMS, min(numStreams, MAX_STREAMS));
+
+    // order-1 codes go in a single stream
+    if (isOrder1) isInterleaved = false;
+
+    // interleaved blocks are for fast decoding, by default limit codewords
+    // to the root decode table so no lookup needs a sub-table
+    if (isInterleaved && !userOptions.count("max-code-length")) {
+        maxCodeLength = HCDecodeTable::DEFAULT_TABLE_BITS;
+    }
+    BlockOptions blockOptions(blockSize, maxCodeLength,
+                              isInterleaved ? numStreams : 1, isOrder1, coder);
+
+    // stdin or stdout, stream a block container or one of the engines. The
+    // functions below report progress on cerr, since out may be stdout
+    if (isStream) {
+        // unsynced, cin reads what the pipe has instead of waiting for a
+        // full request, and can tell when the next read would wait
+        ios::sync_with_stdio(false);
+        ifstream inFile;
+        ofstream outFile;
+        if (!FileUtils::isStdStream(inFileName)) {
+            inFile.open(inFileName, ios::binary);
+            if (!inFile.is_open()) {
+                cerr << "Could not read " << inFileName
+                     << ". Please try again.\n";
+                return 0;
+            }
+        }
+        if (!FileUtils::isStdStream(outFileName)) {
+            outFile.open(outFileName, ios::binary);
+            if (!outFile.is_open()) {
+                cerr << "Could not write " << outFileName
+                     << ". Please try again.\n";
+                return 0;
+            }
+        }
+        istream& in = FileUtils::isStdStream(inFileName) ? cin : inFile;
+        ostream& out = FileUtils::isStdStream(outFileName) ? cout : outFile;
+        if (isAdaptive) {
+            adaptiveCompression(in, out);
+        } else if (isTunstall || isRange) {
+            // the code or model seed is built from the whole input, which
+            // stdin can't give in bounded memory; a file input is mapped
+            if (FileUtils::isStdStream(inFileName)) {
+                cerr << "The " << engineName << " engine needs a file to "
+                     << "read from, not stdin. Please try again.\n";
+                return 0;
+            }
+            InputBuffer input(inFileName);
+            if (!input.isOpen()) return 0;
+            if (isTunstall) {
+                tunstallCompression(input.getData(), input.size(), out,
+                                    codeBits);
+            } else {
+                rangeCompression(input.getData(), input.size(), out,
+                                 isOrder1);
+            }
+        } else {
+            streamCompression(in, out, blockOptions, numThreads);
+        }
         return 0;
     }
 
@@ -147,8 +421,29 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    if (isAsciiOutput) {
+    if (isAdaptive) {
+        ifstream in(inFileName, ios::binary);
+        ofstream out(outFileName, ios::binary);
+        adaptiveCompression(in, out);
+    } else if (isTunstall) {
+        InputBuffer in(inFileName);
+        ofstream out(outFileName, ios::binary);
+        if (in.isOpen()) {
+            tunstallCompression(in.getData(), in.size(), out, codeBits);
+        }
+    } else if (isRange) {
+        InputBuffer in(inFileName);
+        ofstream out(outFileName, ios::binary);
+        if (in.isOpen()) {
+            rangeCompression(in.getData(), in.size(), out, isOrder1);
+        }
+    } else if (isAsciiOutput) {
         pseudoCompression(inFileName, outFileName);
+    } else if (isBlock || isInterleaved || isOrder1 ||
+               userOptions.count("coder") || numThreads > 0) {
+        blockCompression(inFileName, outFileName, blockOptions, numThreads);
+    } else if (isCanonical) {
+        canonicalCompression(inFileName, outFileName, maxCodeLength);
     } else {
         trueCompression(inFileName, outFileName);
     }
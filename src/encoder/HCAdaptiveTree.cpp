@@ -0,0 +1,175 @@
+#include "HCAdaptiveTree.hpp"
+
+#include <algorithm>
+
+const unsigned int HCAdaptiveTree::END_SYMBOL;
+const unsigned int HCAdaptiveTree::SYMBOL_BITS;
+const uint16_t HCAdaptiveTree::NO_NODE;
+
+/* Number of coded or decoded bytes collected before each write to out */
+const size_t STREAM_BUFFER_SIZE = 1 << 16;
+
+// one leaf per byte value, the NYT leaf, and the internal nodes above them
+const unsigned int MAX_NODES = 2 * 256 + 1;
+
+HCAdaptiveTree::HCAdaptiveTree()
+    : order(MAX_NODES, NO_NODE),
+      leaves(HCAdaptiveTree::END_SYMBOL, NO_NODE),
+      root(0),
+      nyt(0) {
+    // the root starts out as the NYT leaf, with the highest number
+    nodes.reserve(MAX_NODES);
+    nodes.push_back(
+        {0, END_SYMBOL, NO_NODE, NO_NODE, NO_NODE, MAX_NODES - 1});
+    order[MAX_NODES - 1] = 0;
+}
+
+void HCAdaptiveTree::writePath(uint16_t node, BitOutputStream& out) const {
+    // collect the path bottom up, then write it top down a word at a time
+    uint64_t words[MAX_NODES / 64 + 1] = {0};
+    unsigned int length = 0;
+    for (uint16_t curr = node; curr != root; curr = nodes[curr].p) {
+        if (nodes[nodes[curr].p].c1 == curr) {
+            words[length / 64] |= uint64_t(1) << (length % 64);
+        }
+        length++;
+    }
+
+    while (length > 0) {
+        unsigned int n = min(length, 56u);
+        uint64_t bits = 0;
+        for (unsigned int i = 0; i < n; i++) {
+            length--;
+            bits = (bits << 1) | ((words[length / 64] >> (length % 64)) & 1);
+        }
+        out.writeBits(bits, n);
+    }
+}
+
+void HCAdaptiveTree::swapNodes(uint16_t a, uint16_t b) {
+    uint16_t pa = nodes[a].p, pb = nodes[b].p;
+    uint16_t& slotA = nodes[pa].c0 == a ? nodes[pa].c0 : nodes[pa].c1;
+    if (pa == pb) {
+        swap(nodes[pa].c0, nodes[pa].c1);
+    } else {
+        uint16_t& slotB = nodes[pb].c0 == b ? nodes[pb].c0 : nodes[pb].c1;
+        slotA = b;
+        slotB = a;
+        swap(nodes[a].p, nodes[b].p);
+    }
+
+    swap(nodes[a].number, nodes[b].number);
+    order[nodes[a].number] = a;
+    order[nodes[b].number] = b;
+}
+
+void HCAdaptiveTree::update(unsigned int symbol) {
+    uint16_t curr = leaves[symbol];
+
+    // new symbol, the NYT leaf splits into a new NYT leaf and the symbol's
+    // leaf, numbered just below it
+    if (curr == NO_NODE) {
+        uint16_t parent = nyt;
+        uint16_t number = nodes[parent].number;
+        uint16_t newNyt = nodes.size();
+        nodes.push_back(
+            {0, END_SYMBOL, NO_NODE, NO_NODE, parent, (uint16_t)(number - 2)});
+        curr = nodes.size();
+        nodes.push_back({0, (uint16_t)symbol, NO_NODE, NO_NODE, parent,
+                         (uint16_t)(number - 1)});
+        order[number - 2] = newNyt;
+        order[number - 1] = curr;
+        nodes[parent].c0 = newNyt;
+        nodes[parent].c1 = curr;
+        leaves[symbol] = curr;
+        nyt = newNyt;
+    }
+
+    // move up to the root, first swapping each node to the top of its
+    // block of equal weights (unless its parent is there)
+    while (curr != NO_NODE) {
+        uint16_t number = nodes[curr].number;
+        while (number + 1u < MAX_NODES && order[number + 1] != NO_NODE &&
+               nodes[order[number + 1]].weight == nodes[curr].weight) {
+            number++;
+        }
+        uint16_t leader = order[number];
+        if (leader != curr && leader != nodes[curr].p) {
+            swapNodes(curr, leader);
+        }
+        nodes[curr].weight++;
+        curr = nodes[curr].p;
+    }
+}
+
+void HCAdaptiveTree::encode(unsigned int symbol, BitOutputStream& out) {
+    uint16_t leaf = symbol < END_SYMBOL ? leaves[symbol] : NO_NODE;
+    if (leaf != NO_NODE) {
+        writePath(leaf, out);
+    } else {
+        writePath(nyt, out);
+        out.writeBits(symbol, SYMBOL_BITS);
+    }
+    if (symbol < END_SYMBOL) update(symbol);
+}
+
+unsigned int HCAdaptiveTree::decode(BitInputStream& in) {
+    uint16_t curr = root;
+    while (!nodes[curr].isLeaf()) {
+        curr = in.readBit() ? nodes[curr].c1 : nodes[curr].c0;
+    }
+
+    unsigned int symbol = nodes[curr].symbol;
+    if (curr == nyt) {
+        symbol = in.readBits(SYMBOL_BITS);
+        if (symbol >= END_SYMBOL || leaves[symbol] != NO_NODE) {
+            return END_SYMBOL;
+        }
+    }
+    update(symbol);
+    return symbol;
+}
+
+void HCAdaptiveTree::encodeStream(istream& in, ostream& out) {
+    HCAdaptiveTree tree;
+    BitOutputStream bos(out, STREAM_BUFFER_SIZE);
+    streambuf* source = in.rdbuf();
+    for (int c = source->sbumpc(); c != EOF; c = source->sbumpc()) {
+        tree.encode(c, bos);
+        // the next byte would have to be waited for, send what we have
+        if (source->in_avail() <= 0) {
+            bos.writeCompleted();
+            out.flush();
+        }
+    }
+    tree.encode(END_SYMBOL, bos);
+    bos.flush();
+    out.flush();
+}
+
+bool HCAdaptiveTree::decodeStream(istream& in, ostream& out) {
+    HCAdaptiveTree tree;
+    // one byte at a time, so no symbol waits for bytes after it
+    BitInputStream bis(in);
+    vector<byte> buffer;
+    buffer.reserve(STREAM_BUFFER_SIZE);
+    while (1) {
+        unsigned int symbol = tree.decode(bis);
+        // a whole stream never needs bits past its last byte
+        if (in.eof()) break;
+        if (symbol == END_SYMBOL) {
+            out.write((const char*)buffer.data(), buffer.size());
+            out.flush();
+            return true;
+        }
+        buffer.push_back(symbol);
+        if (buffer.size() == STREAM_BUFFER_SIZE ||
+            in.rdbuf()->in_avail() <= 0) {
+            out.write((const char*)buffer.data(), buffer.size());
+            out.flush();
+            buffer.clear();
+        }
+    }
+    out.write((const char*)buffer.data(), buffer.size());
+    return false;
+}
@@ -0,0 +1,88 @@
+#ifndef HCADAPTIVETREE_HPP
+#define HCADAPTIVETREE_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../bitStream/input/BitInputStream.hpp"
+#include "../bitStream/output/BitOutputStream.hpp"
+
+using namespace std;
+
+/** A dynamic Huffman tree (the FGK algorithm). The encoder and decoder start
+ * from the same empty tree and update it the same way after every symbol,
+ * so the code follows the data as it goes and no frequency header is
+ * needed. A symbol seen for the first time is sent as the codeword of the
+ * NYT ("not yet transmitted") leaf followed by the symbol in 9 bits, which
+ * also leaves room for END_SYMBOL to mark the end of the data.
+ *
+ * The tree keeps the sibling property: numbering the nodes from the bottom
+ * up, left to right, gives non-decreasing weights. Before a node's weight
+ * goes up it is swapped with the highest numbered node of the same weight,
+ * which keeps the property intact.
+ */
+class HCAdaptiveTree {
+  public:
+    /* Symbol marking the end of the data, after the 256 byte values */
+    static const unsigned int END_SYMBOL = 256;
+
+    /* Number of bits of a symbol sent after the NYT codeword */
+    static const unsigned int SYMBOL_BITS = 9;
+
+    /* Index used for a missing child, parent or leaf */
+    static const uint16_t NO_NODE = 0xFFFF;
+
+  private:
+    /* A node of the tree, children and parent are indices into nodes */
+    struct Node {
+        unsigned int weight;  // number of times the subtree was coded
+        uint16_t symbol;      // symbol of a leaf
+        uint16_t c0;          // index of '0' child
+        uint16_t c1;          // index of '1' child
+        uint16_t p;           // index of parent
+        uint16_t number;      // position in the sibling order
+
+        bool isLeaf() const { return c0 == NO_NODE; }
+    };
+
+    vector<Node> nodes;          // every node of the tree
+    vector<uint16_t> order;      // node index at every sibling order number
+    vector<uint16_t> leaves;     // leaf index of every symbol seen so far
+    uint16_t root;               // index of the root
+    uint16_t nyt;                // index of the NYT leaf
+
+    // write the codeword of node, the path from the root down to it
+    void writePath(uint16_t node, BitOutputStream& out) const;
+
+    // swap two nodes in the tree and in the sibling order
+    void swapNodes(uint16_t a, uint16_t b);
+
+    // count one more of symbol, adding a leaf for it if it is new
+    void update(unsigned int symbol);
+
+  public:
+    /* Start from a tree holding only the NYT leaf */
+    HCAdaptiveTree();
+
+    /* Write the codeword of symbol (a byte or END_SYMBOL), then update the
+     * tree */
+    void encode(unsigned int symbol, BitOutputStream& out);
+
+    /* Read one symbol written by encode() and update the tree the same way.
+     * Returns END_SYMBOL at the end of the data */
+    unsigned int decode(BitInputStream& in);
+
+    /* Code every byte of in, then END_SYMBOL, to out. Whenever in has no
+     * byte ready, the bytes coded so far (all but the last partial one)
+     * are written and out is flushed, so the output keeps up with a slow
+     * producer instead of waiting for a buffer to fill */
+    static void encodeStream(istream& in, ostream& out);
+
+    /* Decode what encodeStream() wrote, reading only the bytes the next
+     * symbol needs. Whenever in has no byte ready, the decoded bytes are
+     * written and out is flushed. Returns false if in ends before
+     * END_SYMBOL */
+    static bool decodeStream(istream& in, ostream& out);
+};
+
+#endif  // HCADAPTIVETREE_HPP
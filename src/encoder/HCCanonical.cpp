@@ -0,0 +1,200 @@
+#include "HCCanonical.hpp"
+
+#include <iterator>
+
+const unsigned int HCCanonical::MAX_LENGTH;
+
+// header layouts, stored in the first header byte
+const byte SPARSE_LAYOUT = 0;
+const byte NIBBLE_LAYOUT = 1;
+
+// number of bytes in the nibble layout, two lengths per byte
+const unsigned int NIBBLE_BYTES = 128;
+
+// a coin in package-merge, either a single symbol or a package of two
+// cheaper coins from the level below
+struct Coin {
+    uint64_t weight;  // total frequency of the symbols in the coin
+    int symbol;       // symbol of a single symbol coin, -1 for a package
+    int c0;           // index of the first coin in a package
+    int c1;           // index of the second coin in a package
+};
+
+// add one to the code length of every symbol in the coin
+static void spendCoin(const vector<Coin>& coins, int index,
+                      vector<unsigned int>& lengths) {
+    const Coin& coin = coins[index];
+    if (coin.symbol >= 0) {
+        lengths[coin.symbol]++;
+        return;
+    }
+    spendCoin(coins, coin.c0, lengths);
+    spendCoin(coins, coin.c1, lengths);
+}
+
+vector<unsigned int> HCCanonical::limitedLengths(
+    const vector<unsigned int>& freqs, unsigned int maxLength) {
+    vector<unsigned int> lengths(256);
+
+    // one coin per used symbol, cheapest first
+    vector<Coin> coins;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] != 0) coins.push_back({freqs[i], i, -1, -1});
+    }
+    stable_sort(coins.begin(), coins.end(), [](const Coin& a, const Coin& b) {
+        return a.weight < b.weight;
+    });
+
+    size_t numSymbols = coins.size();
+    if (numSymbols == 0) return lengths;
+    if (numSymbols == 1) {
+        lengths[coins[0].symbol] = 1;
+        return lengths;
+    }
+
+    // maxLength bits must be enough for numSymbols codewords
+    while ((uint64_t(1) << maxLength) < numSymbols) maxLength++;
+    maxLength = min(maxLength, MAX_LENGTH);
+
+    // the symbol coins sit at the front of coins, in weight order
+    vector<int> symbolCoins;
+    for (size_t i = 0; i < numSymbols; i++) symbolCoins.push_back(i);
+
+    // each level merges the symbol coins with packages made by pairing up
+    // the coins of the level below
+    vector<int> level = symbolCoins;
+    for (unsigned int depth = 1; depth < maxLength; depth++) {
+        vector<int> packages;
+        for (size_t i = 0; i + 1 < level.size(); i += 2) {
+            uint64_t weight =
+                coins[level[i]].weight + coins[level[i + 1]].weight;
+            coins.push_back({weight, -1, level[i], level[i + 1]});
+            packages.push_back(coins.size() - 1);
+        }
+
+        level.clear();
+        merge(symbolCoins.begin(), symbolCoins.end(), packages.begin(),
+              packages.end(), back_inserter(level), [&](int a, int b) {
+                  return coins[a].weight < coins[b].weight;
+              });
+    }
+
+    // the 2n - 2 cheapest coins of the top level pay for the optimal code,
+    // each symbol's length is the number of times it is spent
+    for (size_t i = 0; i < 2 * numSymbols - 2; i++) {
+        spendCoin(coins, level[i], lengths);
+    }
+    return lengths;
+}
+
+vector<unsigned int> HCCanonical::codeLengths(const vector<HCCode>& codes) {
+    vector<unsigned int> lengths(256);
+    for (int i = 0; i < 256 && i < (int)codes.size(); i++) {
+        lengths[i] = codes[i].length;
+    }
+    return lengths;
+}
+
+vector<HCCode> HCCanonical::codesFromLengths(
+    const vector<unsigned int>& lengths) {
+    vector<HCCode> codes(256);
+
+    // count the codewords of each length
+    vector<unsigned int> lengthCount(MAX_LENGTH + 1);
+    for (int i = 0; i < 256; i++) {
+        if (lengths[i] != 0) lengthCount[lengths[i]]++;
+    }
+
+    // first codeword of each length follows on from the last codeword of
+    // the length before it
+    vector<uint64_t> nextCode(MAX_LENGTH + 1);
+    uint64_t code = 0;
+    for (unsigned int len = 1; len <= MAX_LENGTH; len++) {
+        code = (code + lengthCount[len - 1]) << 1;
+        nextCode[len] = code;
+    }
+
+    // walking symbols in order hands out same-length codewords in order
+    for (int i = 0; i < 256; i++) {
+        if (lengths[i] == 0) continue;
+        codes[i] = HCCode(nextCode[lengths[i]]++, lengths[i]);
+    }
+    return codes;
+}
+
+/* Whether lengths are written in the nibble layout, and how many symbols
+ * have a codeword */
+static bool isNibbleLayout(const vector<unsigned int>& lengths,
+                           unsigned int& numSymbols) {
+    numSymbols = 0;
+    unsigned int longest = 0;
+    for (int i = 0; i < 256; i++) {
+        if (lengths[i] == 0) continue;
+        numSymbols++;
+        longest = max(longest, lengths[i]);
+    }
+
+    // sparse layout costs 2 bytes per symbol, nibbles need lengths < 16
+    return longest < 16 && 2 * numSymbols > NIBBLE_BYTES;
+}
+
+size_t HCCanonical::lengthsSize(const vector<unsigned int>& lengths) {
+    unsigned int numSymbols;
+    if (isNibbleLayout(lengths, numSymbols)) return 1 + NIBBLE_BYTES;
+    return 2 + 2 * numSymbols;
+}
+
+void HCCanonical::writeLengths(ostream& out,
+                               const vector<unsigned int>& lengths) {
+    unsigned int numSymbols;
+    if (isNibbleLayout(lengths, numSymbols)) {
+        out.put(NIBBLE_LAYOUT);
+        for (int i = 0; i < 256; i += 2) {
+            out.put((char)((lengths[i] << 4) | lengths[i + 1]));
+        }
+        return;
+    }
+
+    out.put(SPARSE_LAYOUT);
+    // number of symbols is 1 to 256, store it minus 1 to fit in a byte
+    out.put((char)(numSymbols - 1));
+    for (int i = 0; i < 256; i++) {
+        if (lengths[i] == 0) continue;
+        out.put((char)i);
+        out.put((char)lengths[i]);
+    }
+}
+
+bool HCCanonical::readLengths(istream& in, vector<unsigned int>& lengths) {
+    lengths.assign(256, 0);
+
+    int layout = in.get();
+    if (layout == NIBBLE_LAYOUT) {
+        for (int i = 0; i < 256; i += 2) {
+            byte pair = in.get();
+            lengths[i] = pair >> 4;
+            lengths[i + 1] = pair & 0xF;
+        }
+    } else if (layout == SPARSE_LAYOUT) {
+        unsigned int numSymbols = (byte)in.get() + 1;
+        for (unsigned int i = 0; i < numSymbols; i++) {
+            byte symbol = in.get();
+            lengths[symbol] = (byte)in.get();
+        }
+    } else {
+        return false;
+    }
+    if (!in.good()) return false;
+
+    // lengths must not oversubscribe the code space (Kraft inequality),
+    // counted in codewords of MAX_LENGTH bits so the sum is exact
+    uint64_t space = uint64_t(1) << MAX_LENGTH;
+    uint64_t used = 0;
+    for (int i = 0; i < 256; i++) {
+        if (lengths[i] > MAX_LENGTH) return false;
+        if (lengths[i] == 0) continue;
+        used += uint64_t(1) << (MAX_LENGTH - lengths[i]);
+        if (used > space) return false;
+    }
+    return used > 0;
+}
@@ -0,0 +1,48 @@
+#ifndef HCCANONICAL_HPP
+#define HCCANONICAL_HPP
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "HCCode.hpp"
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** Helpers for canonical Huffman codes. A canonical code is fully described
+ * by the codeword length of every symbol, so only the lengths have to be
+ * stored in a compressed file header, and the decoder can rebuild its tables
+ * from them without building an HCTree.
+ */
+class HCCanonical {
+  public:
+    /* Longest codeword length a header can describe */
+    static const unsigned int MAX_LENGTH = 57;
+
+    /* Compute optimal code lengths of at most maxLength bits for the given
+     * symbol frequencies with the package-merge algorithm. maxLength is
+     * raised if it is too short to give every used symbol a codeword */
+    static vector<unsigned int> limitedLengths(
+        const vector<unsigned int>& freqs, unsigned int maxLength);
+
+    /* Get the codeword length of every symbol from a code table */
+    static vector<unsigned int> codeLengths(const vector<HCCode>& codes);
+
+    /* Assign canonical codewords: shorter codewords come first, and
+     * codewords of the same length are in increasing symbol order */
+    static vector<HCCode> codesFromLengths(const vector<unsigned int>& lengths);
+
+    /* Write the 256 code lengths in the smaller of two layouts: a sparse
+     * list of (symbol, length) pairs, or one 4-bit length per symbol */
+    static void writeLengths(ostream& out, const vector<unsigned int>& lengths);
+
+    /* Number of bytes writeLengths writes for lengths */
+    static size_t lengthsSize(const vector<unsigned int>& lengths);
+
+    /* Read code lengths written by writeLengths. Returns false if the
+     * header is truncated or describes lengths no code could have */
+    static bool readLengths(istream& in, vector<unsigned int>& lengths);
+};
+
+#endif  // HCCANONICAL_HPP
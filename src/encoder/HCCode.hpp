@@ -0,0 +1,18 @@
+#ifndef HCCODE_HPP
+#define HCCODE_HPP
+
+#include <cstdint>
+
+/** A Huffman codeword. The code is stored in the low 'length' bits of 'bits'
+ * and is written most significant bit first. A length of 0 means the symbol
+ * has no codeword.
+ */
+struct HCCode {
+    uint64_t bits;        // the codeword, right aligned
+    unsigned int length;  // number of bits in the codeword
+
+    HCCode(uint64_t bits = 0, unsigned int length = 0)
+        : bits(bits), length(length) {}
+};
+
+#endif  // HCCODE_HPP
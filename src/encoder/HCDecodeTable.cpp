@@ -0,0 +1,222 @@
+#include "HCDecodeTable.hpp"
+
+#include <map>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DECODE_X86 1
+#endif
+
+// longest root table the AVX2 kernel can index, its 4-byte loads give at
+// least 25 bits past any bit position
+const unsigned int MAX_FLAT_BITS = 24;
+
+HCDecodeTable::HCDecodeTable(const vector<HCCode>& codes,
+                             unsigned int tableBits)
+    : rootBits(1), maxBits(tableBits == 0 ? 1 : tableBits) {
+    vector<int> symbols;
+    for (int i = 0; i < (int)codes.size(); i++) {
+        if (codes[i].length != 0) symbols.push_back(i);
+    }
+
+    // no codewords at all, leave a root table that decodes to symbol 0
+    if (symbols.empty()) {
+        entries.resize(2, {0, 1, 0});
+        return;
+    }
+
+    buildTable(codes, symbols, 0, rootBits);
+
+    // no sub-tables, keep a copy of the root table the AVX2 kernel can gather
+    for (uint32_t i = 0; i < (1u << rootBits); i++) {
+        if (entries[i].isLink || rootBits > MAX_FLAT_BITS) {
+            flat.clear();
+            break;
+        }
+        flat.push_back(entries[i].value | uint32_t(entries[i].bits) << 8);
+    }
+}
+
+uint32_t HCDecodeTable::buildTable(const vector<HCCode>& codes,
+                                   const vector<int>& symbols,
+                                   unsigned int consumed,
+                                   unsigned int& width) {
+    // the table only needs to be as wide as the longest remaining codeword
+    unsigned int longest = 1;
+    for (int symbol : symbols) {
+        longest = max(longest, codes[symbol].length - consumed);
+    }
+    width = min(longest, maxBits);
+
+    // entries no codeword reaches decode to symbol 0 so bad input can't loop
+    uint32_t offset = entries.size();
+    entries.resize(offset + (1u << width), {0, (uint8_t)width, 0});
+
+    // symbols whose codeword continues past this table, grouped by the bits
+    // they use to index this table
+    map<uint32_t, vector<int>> longer;
+
+    for (int symbol : symbols) {
+        unsigned int remaining = codes[symbol].length - consumed;
+        uint64_t bits = codes[symbol].bits & ((uint64_t(1) << remaining) - 1);
+
+        if (remaining > width) {
+            longer[bits >> (remaining - width)].push_back(symbol);
+            continue;
+        }
+
+        // every index starting with the codeword decodes to this symbol
+        uint32_t first = bits << (width - remaining);
+        uint32_t count = 1u << (width - remaining);
+        for (uint32_t i = first; i < first + count; i++) {
+            entries[offset + i] = {(uint32_t)symbol, (uint8_t)remaining, 0};
+        }
+    }
+
+    for (auto& group : longer) {
+        unsigned int subWidth;
+        uint32_t subOffset =
+            buildTable(codes, group.second, consumed + width, subWidth);
+        entries[offset + group.first] = {subOffset, (uint8_t)subWidth, 1};
+    }
+
+    return offset;
+}
+
+/* Decode n symbols from the bit stream into out */
+void HCDecodeTable::decode(BitInputStream& in, byte* out, size_t n) const {
+    for (size_t i = 0; i < n; i++) out[i] = decode(in);
+}
+
+/* Decode n symbols dealt round-robin over numStreams cursors into out */
+void HCDecodeTable::decode(BitCursor* cursors, unsigned int numStreams,
+                           byte* out, size_t n) const {
+    size_t rounds = n / numStreams;
+
+    // the usual stream count, with the cursors in locals the compiler can
+    // keep in registers
+    if (numStreams == 4) {
+        BitCursor c0 = cursors[0], c1 = cursors[1];
+        BitCursor c2 = cursors[2], c3 = cursors[3];
+        for (size_t r = 0; r < rounds; r++, out += 4) {
+            out[0] = decode(c0);
+            out[1] = decode(c1);
+            out[2] = decode(c2);
+            out[3] = decode(c3);
+        }
+        cursors[0] = c0, cursors[1] = c1, cursors[2] = c2, cursors[3] = c3;
+    } else {
+        for (size_t r = 0; r < rounds; r++, out += numStreams) {
+            for (unsigned int s = 0; s < numStreams; s++) {
+                out[s] = decode(cursors[s]);
+            }
+        }
+    }
+
+    // the last partial round
+    for (unsigned int s = 0; s < n % numStreams; s++) {
+        out[s] = decode(cursors[s]);
+    }
+}
+
+void HCDecodeTable::decode(const byte* data, const size_t* offsets,
+                           const size_t* sizes, unsigned int numStreams,
+                           byte* out, size_t n) const {
+    vector<uint32_t> bitPos(numStreams, 0);
+    size_t done = 0;
+
+    // decide once, on the first call
+    static const bool useAVX2 = hasAVX2();
+    if (useAVX2 && numStreams == AVX2_LANES && hasFlatTable()) {
+        done = numStreams * decodeAVX2(data, offsets, sizes, bitPos.data(),
+                                       out, n / numStreams);
+    }
+
+    // the cursors pick up where the kernel left off
+    vector<BitCursor> cursors(numStreams);
+    for (unsigned int s = 0; s < numStreams; s++) {
+        size_t skip = bitPos[s] / 8;
+        cursors[s] = BitCursor(data + offsets[s] + skip, sizes[s] - skip);
+        if (bitPos[s] % 8 != 0) cursors[s].readBits(bitPos[s] % 8);
+    }
+    decode(cursors.data(), numStreams, out + done, n - done);
+}
+
+#ifdef DECODE_X86
+
+__attribute__((target("avx2"))) size_t HCDecodeTable::decodeAVX2(
+    const byte* data, const size_t* offsets, const size_t* sizes,
+    uint32_t* bitPos, byte* out, size_t rounds) const {
+    // byte offset of every stream, bit position in every stream
+    __m256i start = _mm256_setr_epi32(offsets[0], offsets[1], offsets[2],
+                                      offsets[3], offsets[4], offsets[5],
+                                      offsets[6], offsets[7]);
+    __m256i pos = _mm256_loadu_si256((const __m256i*)bitPos);
+
+    // turn 4 loaded bytes into a big-endian word
+    const __m256i byteSwap = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6,
+        5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    // collect the symbol byte of every lane into the low 8 bytes
+    const __m256i packSymbols = _mm256_setr_epi8(
+        0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8,
+        12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i packHalves = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+    const __m256i seven = _mm256_set1_epi32(7);
+    const __m128i indexShift = _mm_cvtsi32_si128(32 - rootBits);
+
+    size_t done = 0;
+    while (done < rounds) {
+        // rounds every stream can run before a 4-byte load could pass its
+        // end, a round moves a cursor at most rootBits bits
+        uint32_t p[AVX2_LANES];
+        _mm256_storeu_si256((__m256i*)p, pos);
+        size_t safe = rounds - done;
+        for (unsigned int l = 0; l < AVX2_LANES; l++) {
+            uint64_t avail = uint64_t(sizes[l]) * 8;
+            if (avail < p[l] + 32) {
+                safe = 0;
+                break;
+            }
+            safe = min(safe, size_t((avail - p[l] - 32) / rootBits + 1));
+        }
+
+        // too close to the end to be worth it, leave it to the cursors
+        if (safe < 16) break;
+
+        for (size_t r = 0; r < safe; r++, out += AVX2_LANES) {
+            __m256i index = _mm256_add_epi32(start, _mm256_srli_epi32(pos, 3));
+            __m256i word = _mm256_i32gather_epi32((const int*)data, index, 1);
+            word = _mm256_shuffle_epi8(word, byteSwap);
+            word = _mm256_sllv_epi32(word, _mm256_and_si256(pos, seven));
+
+            __m256i entry = _mm256_i32gather_epi32(
+                (const int*)flat.data(), _mm256_srl_epi32(word, indexShift),
+                4);
+            pos = _mm256_add_epi32(pos, _mm256_srli_epi32(entry, 8));
+
+            __m256i symbols = _mm256_permutevar8x32_epi32(
+                _mm256_shuffle_epi8(entry, packSymbols), packHalves);
+            _mm_storel_epi64((__m128i*)out, _mm256_castsi256_si128(symbols));
+        }
+        done += safe;
+    }
+
+    _mm256_storeu_si256((__m256i*)bitPos, pos);
+    return done;
+}
+
+bool HCDecodeTable::hasAVX2() { return __builtin_cpu_supports("avx2"); }
+
+#else
+
+// no AVX2 on other CPUs, the cursors decode everything
+size_t HCDecodeTable::decodeAVX2(const byte* data, const size_t* offsets,
+                                 const size_t* sizes, uint32_t* bitPos,
+                                 byte* out, size_t rounds) const {
+    return 0;
+}
+
+bool HCDecodeTable::hasAVX2() { return false; }
+
+#endif
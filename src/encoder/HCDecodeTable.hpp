@@ -0,0 +1,95 @@
+#ifndef HCDECODETABLE_HPP
+#define HCDECODETABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "../bitStream/input/BitCursor.hpp"
+#include "../bitStream/input/BitInputStream.hpp"
+#include "HCCode.hpp"
+
+using namespace std;
+
+/** A multi-level lookup table for decoding Huffman codewords. The decoder
+ * peeks the next rootBits bits, and the table entry either gives the symbol
+ * and its codeword length, or links to a sub-table for the next bits of a
+ * longer codeword. Each table level is at most tableBits wide, so the tables
+ * stay small even for very long codewords.
+ */
+class HCDecodeTable {
+  private:
+    struct Entry {
+        uint32_t value;  // decoded symbol, or offset of the linked sub-table
+        uint8_t bits;    // bits to consume, or width of the linked sub-table
+        uint8_t isLink;  // 1 if this entry links to a sub-table
+    };
+
+    vector<Entry> entries;  // all table levels, the root table comes first
+    unsigned int rootBits;  // width of the root table
+    unsigned int maxBits;   // maximum width of any table level
+    vector<uint32_t> flat;  // root table as symbol | bits << 8, only when
+                            // there are no sub-tables (for the AVX2 kernel)
+
+    // build the table for the given symbols, which all share the same first
+    // 'consumed' codeword bits; returns its offset and sets its width
+    uint32_t buildTable(const vector<HCCode>& codes, const vector<int>& symbols,
+                        unsigned int consumed, unsigned int& width);
+
+  public:
+    /* Default width of a table level, keeps the root table in L1 cache */
+    static const unsigned int DEFAULT_TABLE_BITS = 11;
+
+    /* Number of sub-streams the AVX2 kernel decodes at once */
+    static const unsigned int AVX2_LANES = 8;
+
+    /* Build the decode tables from a code table indexed by symbol */
+    explicit HCDecodeTable(const vector<HCCode>& codes,
+                           unsigned int tableBits = DEFAULT_TABLE_BITS);
+
+    /* Decode the next symbol from a BitInputStream or BitCursor */
+    template <typename BitReader>
+    byte decode(BitReader& in) const {
+        unsigned int width = rootBits;
+        const Entry* e = &entries[in.peekBits(width)];
+
+        // longer codeword, move on to the sub-table for its next bits
+        while (e->isLink) {
+            in.consumeBits(width);
+            width = e->bits;
+            e = &entries[e->value + in.peekBits(width)];
+        }
+
+        in.consumeBits(e->bits);
+        return (byte)e->value;
+    }
+
+    void decode(BitInputStream& in, byte* out, size_t n) const;
+
+    /* Decode n symbols dealt round-robin over numStreams sub-streams, so
+     * symbol i comes from cursors[i % numStreams]. The cursors are advanced
+     * in the same loop, so the lookups of different streams overlap */
+    void decode(BitCursor* cursors, unsigned int numStreams, byte* out,
+                size_t n) const;
+
+    /* Same as above, with stream s being the sizes[s] bytes at
+     * data + offsets[s]. Uses the AVX2 kernel for 8 streams when the CPU and
+     * the table allow it, and the cursors for the rest */
+    void decode(const byte* data, const size_t* offsets, const size_t* sizes,
+                unsigned int numStreams, byte* out, size_t n) const;
+
+    /* AVX2 kernel for AVX2_LANES streams laid out as above, one gather
+     * looks up a symbol for every stream. bitPos holds the bit position in
+     * each stream before and after. Decodes up to 'rounds' rounds of 8
+     * symbols while no stream would be read past its end, and returns the
+     * number of rounds decoded. Only for tables with hasFlatTable() */
+    size_t decodeAVX2(const byte* data, const size_t* offsets,
+                      const size_t* sizes, uint32_t* bitPos, byte* out,
+                      size_t rounds) const;
+
+    /* Whether every codeword fits in the root table */
+    bool hasFlatTable() const { return !flat.empty(); }
+
+    /* Whether the CPU can run the AVX2 kernel */
+    static bool hasAVX2();
+};
+
+#endif  // HCDECODETABLE_HPP
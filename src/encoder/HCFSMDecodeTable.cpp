@@ -0,0 +1,88 @@
+#include "HCFSMDecodeTable.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// child in the code tree: a state, a leaf (~symbol), or nothing
+const int NO_CHILD = 1 << 16;
+
+HCFSMDecodeTable::HCFSMDecodeTable(const vector<HCCode>& codes)
+    : numStates(0) {
+    // the code tree, one pair of children per internal node
+    vector<pair<int, int>> tree(1, make_pair(NO_CHILD, NO_CHILD));
+    for (int symbol = 0; symbol < (int)codes.size(); symbol++) {
+        unsigned int length = codes[symbol].length;
+        if (length == 0) continue;
+
+        int node = 0;
+        for (unsigned int i = length; i-- > 0;) {
+            int& child = (codes[symbol].bits >> i) & 1 ? tree[node].second
+                                                       : tree[node].first;
+            if (i == 0) {
+                child = ~symbol;
+            } else {
+                if (child == NO_CHILD) {
+                    if (tree.size() == MAX_STATES) return;
+                    child = tree.size();
+                }
+                node = child;
+                if (node == (int)tree.size()) {
+                    tree.push_back(make_pair(NO_CHILD, NO_CHILD));
+                }
+            }
+        }
+    }
+
+    // follow the 8 bits of every byte from every state; a missing child
+    // decodes to symbol 0 so bad input can't get stuck
+    numStates = tree.size();
+    entries.resize(numStates * 256);
+    for (unsigned int state = 0; state < numStates; state++) {
+        for (unsigned int b = 0; b < 256; b++) {
+            Entry& e = entries[state * 256 + b];
+            memset(&e, 0, sizeof(e));
+            int node = state;
+            for (int bit = 7; bit >= 0; bit--) {
+                int child =
+                    (b >> bit) & 1 ? tree[node].second : tree[node].first;
+                if (child >= 0 && child != NO_CHILD) {
+                    node = child;
+                    continue;
+                }
+                e.symbols[e.count++] = child == NO_CHILD ? 0 : ~child;
+                node = 0;
+            }
+            e.next = node;
+        }
+    }
+}
+
+void HCFSMDecodeTable::decode(const byte* data, size_t size, byte* out,
+                              size_t n) const {
+    if (!isValid()) {
+        fill(out, out + n, 0);
+        return;
+    }
+
+    unsigned int state = 0;
+    size_t i = 0, pos = 0;
+
+    // every entry is copied whole, so stop while a full copy still fits
+    while (i + 8 <= n && pos < size) {
+        const Entry& e = entries[state * 256 + data[pos++]];
+        memcpy(out + i, e.symbols, 8);
+        i += e.count;
+        state = e.next;
+    }
+
+    // the last few symbols, and 0s past the end of data
+    while (i < n) {
+        byte next = pos < size ? data[pos] : 0;
+        pos++;
+        const Entry& e = entries[state * 256 + next];
+        size_t count = min((size_t)e.count, n - i);
+        memcpy(out + i, e.symbols, count);
+        i += count;
+        state = e.next;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef HCFSMDECODETABLE_HPP
+#define HCFSMDECODETABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "HCCode.hpp"
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** A finite state machine that decodes a whole input byte per step. The
+ * states are the internal nodes of the code tree, and the entry for a state
+ * and the next input byte holds the state those 8 bits lead to and every
+ * symbol finished on the way. The decode loop is one table lookup per input
+ * byte with no bit-level work at all, at the price of a table of
+ * 256 entries per internal node (about 750 KiB for a full byte alphabet),
+ * which lives in L2 rather than L1 cache.
+ */
+class HCFSMDecodeTable {
+  public:
+    /* Most states a table is built for, a complete code over a byte
+     * alphabet has at most 255 internal nodes */
+    static const unsigned int MAX_STATES = 256;
+
+  private:
+    struct Entry {
+        byte symbols[8];  // symbols finished in this byte, the first count
+        uint16_t next;    // state after the byte
+        uint8_t count;    // number of symbols finished
+    };
+
+    vector<Entry> entries;  // 256 entries for every state, state 0 first
+    unsigned int numStates; // number of states, 0 if the code didn't fit
+
+  public:
+    /* Build the state machine from a code table indexed by symbol */
+    explicit HCFSMDecodeTable(const vector<HCCode>& codes);
+
+    /* Whether the code was small enough to build the state machine for */
+    bool isValid() const { return numStates != 0; }
+
+    /* Decode n symbols from the bit stream in the size bytes at data, which
+     * starts on a byte boundary. Past the end of data, 0 bits are read */
+    void decode(const byte* data, size_t size, byte* out, size_t n) const;
+};
+
+#endif  // HCFSMDECODETABLE_HPP
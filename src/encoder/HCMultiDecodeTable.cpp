@@ -0,0 +1,63 @@
+#include "HCMultiDecodeTable.hpp"
+
+#include <cstring>
+
+HCMultiDecodeTable::HCMultiDecodeTable(const vector<HCCode>& codes,
+                                       unsigned int tableBits)
+    : tableBits(tableBits == 0 ? 1 : tableBits), single(codes) {
+    // first[i] is the symbol whose codeword starts the bits of i, with its
+    // length, for codewords no longer than the table (length 0 if none)
+    uint32_t size = 1u << this->tableBits;
+    vector<pair<byte, unsigned int>> first(size, make_pair(0, 0));
+    for (int symbol = 0; symbol < (int)codes.size(); symbol++) {
+        unsigned int length = codes[symbol].length;
+        if (length == 0 || length > this->tableBits) continue;
+        uint32_t start = codes[symbol].bits << (this->tableBits - length);
+        uint32_t count = 1u << (this->tableBits - length);
+        for (uint32_t i = start; i < start + count; i++) {
+            first[i] = make_pair((byte)symbol, length);
+        }
+    }
+
+    // take whole codewords from the front of every bit pattern; the bits
+    // shifted in past the end are unknown, so a codeword must end in time
+    entries.resize(size);
+    for (uint32_t i = 0; i < size; i++) {
+        Entry& e = entries[i];
+        memset(&e, 0, sizeof(e));
+        while (e.count < MAX_SYMBOLS) {
+            const pair<byte, unsigned int>& next =
+                first[(i << e.bits) & (size - 1)];
+            if (next.second == 0 || next.second > this->tableBits - e.bits) {
+                break;
+            }
+            e.symbols[e.count++] = next.first;
+            e.bits += next.second;
+        }
+    }
+}
+
+void HCMultiDecodeTable::decode(BitInputStream& in, byte* out,
+                                size_t n) const {
+    size_t i = 0;
+
+    // every entry is copied whole, so stop while a full copy still fits
+    while (i + MAX_SYMBOLS <= n) {
+        const Entry& e = entries[in.peekBits(tableBits)];
+        if (e.count == 0) {
+            out[i++] = single.decode(in);
+            continue;
+        }
+        memcpy(out + i, e.symbols, MAX_SYMBOLS);
+        in.consumeBits(e.bits);
+        i += e.count;
+    }
+
+    // the last few one at a time, so no bits past symbol n are consumed
+    for (; i < n; i++) out[i] = single.decode(in);
+}
+
+bool HCMultiDecodeTable::paysOff(double averageBits, unsigned int tableBits) {
+    // room for two average codewords per lookup
+    return averageBits * 2 <= tableBits;
+}
@@ -0,0 +1,52 @@
+#ifndef HCMULTIDECODETABLE_HPP
+#define HCMULTIDECODETABLE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "../bitStream/input/BitInputStream.hpp"
+#include "HCCode.hpp"
+#include "HCDecodeTable.hpp"
+
+using namespace std;
+
+/** A lookup table that decodes several symbols per lookup. The entry for
+ * the next tableBits bits holds every whole codeword in them, up to
+ * MAX_SYMBOLS symbols, plus the bits they take up. With short codewords one
+ * lookup gives two or three bytes. Entries whose first codeword doesn't fit
+ * in tableBits fall back to a regular HCDecodeTable.
+ */
+class HCMultiDecodeTable {
+  public:
+    /* Most symbols a single entry decodes to */
+    static const unsigned int MAX_SYMBOLS = 4;
+
+    /* Default table width, 4096 entries of 8 bytes still fit in L1 cache */
+    static const unsigned int DEFAULT_TABLE_BITS = 12;
+
+  private:
+    struct Entry {
+        byte symbols[MAX_SYMBOLS];  // decoded symbols, the first count valid
+        uint8_t count;  // number of symbols, 0 to use the fallback table
+        uint8_t bits;   // bits taken up by the symbols
+    };
+
+    vector<Entry> entries;   // one entry for every tableBits bit pattern
+    unsigned int tableBits;  // width of the table
+    HCDecodeTable single;    // for codewords longer than tableBits
+
+  public:
+    /* Build the table from a code table indexed by symbol */
+    explicit HCMultiDecodeTable(const vector<HCCode>& codes,
+                                unsigned int tableBits = DEFAULT_TABLE_BITS);
+
+    /* Decode n symbols from the bit stream into out, consuming only the
+     * bits of those n symbols */
+    void decode(BitInputStream& in, byte* out, size_t n) const;
+
+    /* Whether codes averaging averageBits bits per symbol decode faster
+     * with this table than with a plain HCDecodeTable */
+    static bool paysOff(double averageBits,
+                        unsigned int tableBits = DEFAULT_TABLE_BITS);
+};
+
+#endif  // HCMULTIDECODETABLE_HPP
@@ -1,9 +1,20 @@
 #include "HCTree.hpp"
 
-/* TODO: Delete all objects on the heap to avoid memory leaks. */
-HCTree::~HCTree() {
-    deleteHCNode(root);
-    delete leaves;
+#include "HCCanonical.hpp"
+
+const uint16_t HCTree::NO_NODE;
+const unsigned int HCTree::MAX_NODES;
+
+uint16_t HCTree::addNodes(HCNode* curr, uint16_t parent) {
+    if (curr == nullptr) return NO_NODE;
+
+    uint16_t index = addNode(curr->count, curr->symbol);
+    nodes[index].p = parent;
+    uint16_t c0 = addNodes(curr->c0, index);
+    uint16_t c1 = addNodes(curr->c1, index);
+    nodes[index].c0 = c0;
+    nodes[index].c1 = c1;
+    return index;
 }
 
 void HCTree::deleteHCNode(HCNode* curr) {
@@ -13,6 +24,47 @@ void HCTree::deleteHCNode(HCNode* curr) {
     delete curr;
 }
 
+/* Start over from an empty node array */
+void HCTree::reset() {
+    nodes.clear();
+    nodes.reserve(MAX_NODES);
+    root = NO_NODE;
+    fill(leaves.begin(), leaves.end(), NO_NODE);
+    fill(codes.begin(), codes.end(), HCCode());
+}
+
+/* Make a new parent of the two given nodes and return its index */
+uint16_t HCTree::combine(uint16_t smaller, uint16_t larger) {
+    // combined node has count of c0 + c1, and symbol of c0
+    uint16_t combined = addNode(nodes[smaller].count + nodes[larger].count,
+                                nodes[smaller].symbol);
+
+    // set children
+    nodes[combined].c0 = smaller;
+    nodes[combined].c1 = larger;
+
+    // set parent
+    nodes[smaller].p = combined;
+    nodes[larger].p = combined;
+    return combined;
+}
+
+/* Fill the leaves vector and code table once the tree is complete, and swap
+ * in a length-limited code if some codeword is too long */
+void HCTree::finishBuild(const vector<unsigned int>& freqs,
+                         unsigned int maxCodeLength) {
+    buildCodes(root, 0, 0);
+
+    // check if any codeword is longer than allowed
+    if (maxCodeLength == 0) return;
+    for (int i = 0; i < 256; i++) {
+        if (codes[i].length > maxCodeLength) {
+            buildLimited(freqs, maxCodeLength);
+            return;
+        }
+    }
+}
+
 /**
  * TODO: Build the HCTree from the given frequency vector. You can assume the
  * vector must have size 256 and each value at index i represents the frequency
@@ -30,17 +82,111 @@ void HCTree::deleteHCNode(HCNode* curr) {
  *    2. When popping two highest priority nodes from PQ, the higher priority
  * node will be the ‘c0’ child of the new parent HCNode.
  *    3. The symbol of any parent node should be taken from its 'c0' child.
+ *
+ * Instead of a priority queue, this uses the linear two-queue method: the
+ * leaves are radix sorted into priority order once, and parents are created
+ * in priority order too, so the next node is always at the front of one of
+ * the two queues. Nodes alive at the same time never tie on both count and
+ * symbol (a parent's symbol comes from a leaf below it), so this builds the
+ * same tree as buildWithPQ().
+ *
+ * If maxCodeLength is not 0 and some codeword comes out longer than it, the
+ * tree is replaced by one for the optimal code with no codeword longer than
+ * maxCodeLength bits (see buildLimited).
+ */
+void HCTree::build(const vector<unsigned int>& freqs,
+                   unsigned int maxCodeLength) {
+    // account for when freqs array is empty
+    if (freqs.empty()) return;
+    reset();
+
+    // used symbols in descending symbol order, then stable LSD radix sort
+    // on count, a byte at a time, to get them in priority order
+    vector<byte> sorted;
+    for (int i = 255; i >= 0; i--) {
+        if (freqs[i] != 0) sorted.push_back(i);
+    }
+    vector<byte> scratch(sorted.size());
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t bucketStart[257] = {0};
+        for (byte symbol : sorted) {
+            bucketStart[((freqs[symbol] >> shift) & 0xFF) + 1]++;
+        }
+        for (int b = 0; b < 256; b++) bucketStart[b + 1] += bucketStart[b];
+        for (byte symbol : sorted) {
+            scratch[bucketStart[(freqs[symbol] >> shift) & 0xFF]++] = symbol;
+        }
+        sorted.swap(scratch);
+    }
+
+    // account for when freqs vector is all 0s
+    if (sorted.empty()) return;
+
+    // leaf queue in priority order
+    vector<uint16_t> leafQueue;
+    for (byte symbol : sorted) {
+        leafQueue.push_back(addNode(freqs[symbol], symbol));
+    }
+    size_t nextLeaf = 0;
+
+    // account for when freqs vector only has 1 entry (can't set root to have a
+    // value)
+    if (leafQueue.size() == 1) {
+        addRootAbove(leafQueue[0]);
+        buildCodes(root, 0, 0);
+        return;
+    }
+
+    // parent queue, kept in priority order as parents are added
+    vector<uint16_t> parentQueue;
+    parentQueue.reserve(leafQueue.size());
+    size_t nextParent = 0;
+
+    // pick the higher priority front of the two queues
+    NodeComp comp = {&nodes};
+    auto takeNext = [&]() -> uint16_t {
+        if (nextLeaf < leafQueue.size() &&
+            (nextParent == parentQueue.size() ||
+             comp(parentQueue[nextParent], leafQueue[nextLeaf])))
+            return leafQueue[nextLeaf++];
+        return parentQueue[nextParent++];
+    };
+
+    for (size_t merges = 1; merges < leafQueue.size(); merges++) {
+        uint16_t smaller = takeNext();
+        uint16_t larger = takeNext();
+        parentQueue.push_back(combine(smaller, larger));
+
+        // a new parent never has a lower count than the ones before it, but
+        // on equal counts the larger symbol has to move ahead
+        for (size_t i = parentQueue.size() - 1;
+             i > nextParent && comp(parentQueue[i - 1], parentQueue[i]); i--)
+            swap(parentQueue[i - 1], parentQueue[i]);
+    }
+
+    // only the root is left in the parent queue
+    root = parentQueue[nextParent];
+    finishBuild(freqs, maxCodeLength);
+}
+
+/**
+ * Build the HCTree with a priority queue, using the tie-breaking rules
+ * described for build(). This gives the same tree as build() in
+ * O(n log n) time and is kept as a reference for the tests.
  */
-void HCTree::build(const vector<unsigned int>& freqs) {
+void HCTree::buildWithPQ(const vector<unsigned int>& freqs,
+                         unsigned int maxCodeLength) {
     // account for when freqs array is empty
     if (freqs.empty()) return;
+    reset();
 
-    priority_queue<HCNode*, vector<HCNode*>, HCNodePtrComp> pq;
+    NodeComp comp = {&nodes};
+    priority_queue<uint16_t, vector<uint16_t>, NodeComp> pq(comp);
 
     // iterate through freqs array
     for (int i = 0; i < 256; i++) {
         // if element has a frequency, push into priority queue
-        if (freqs[i] != 0) pq.push(new HCNode(freqs[i], (unsigned char)i));
+        if (freqs[i] != 0) pq.push(addNode(freqs[i], (unsigned char)i));
     }
 
     // account for when freqs vector is all 0s
@@ -49,15 +195,8 @@ void HCTree::build(const vector<unsigned int>& freqs) {
     // account for when freqs vector only has 1 entry (can't set root to have a
     // value)
     if (pq.size() == 1) {
-        HCNode* node = pq.top();
-        root = new HCNode(node->count, node->symbol);
-
-        root->c0 = node;
-        root->c1 = nullptr;
-
-        leaves->at(node->symbol) = node;
-        node->p = root;
-
+        addRootAbove(pq.top());
+        buildCodes(root, 0, 0);
         return;
     }
 
@@ -66,37 +205,85 @@ void HCTree::build(const vector<unsigned int>& freqs) {
     while (pq.size() > 1) {
         // if more than one element in priority queue, need to keep popping,
         // combining, and pushing back
-        HCNode* smaller = pq.top();
+        uint16_t smaller = pq.top();
         pq.pop();
-        HCNode* larger = pq.top();
+        uint16_t larger = pq.top();
         pq.pop();
 
-        // if popped node is a leaf, add to leaves vector
-        if (smaller->c0 == nullptr && smaller->c1 == nullptr)
-            leaves->at(smaller->symbol) = smaller;
-        // leaves[smaller->symbol] = smaller;
-        if (larger->c0 == nullptr && larger->c1 == nullptr)
-            leaves->at(larger->symbol) = larger;
-        // leaves[larger->symbol] = larger;
+        // push back into priority queue
+        pq.push(combine(smaller, larger));
+    }
+
+    // priority queue only has 1 element left, set to root
+    root = pq.top();
+    finishBuild(freqs, maxCodeLength);
+}
 
-        // combined node has count of c0 + c1, and symbol of c0
-        HCNode* combined =
-            new HCNode(smaller->count + larger->count, smaller->symbol);
+/* Make the root a parent whose only child is the given node */
+void HCTree::addRootAbove(uint16_t node) {
+    root = addNode(nodes[node].count, nodes[node].symbol);
+    nodes[root].c0 = node;
+    nodes[node].p = root;
+}
 
-        // set children
-        combined->c0 = smaller;
-        combined->c1 = larger;
+/**
+ * Rebuild the tree from the canonical code with optimal code lengths of at
+ * most maxCodeLength bits, found with package-merge. Each codeword's path is
+ * added from the root, so the tree, the leaves vector and the code table all
+ * describe the same length-limited code.
+ */
+void HCTree::buildLimited(const vector<unsigned int>& freqs,
+                          unsigned int maxCodeLength) {
+    vector<HCCode> limited = HCCanonical::codesFromLengths(
+        HCCanonical::limitedLengths(freqs, maxCodeLength));
 
-        // set parent
-        smaller->p = combined;
-        larger->p = combined;
+    reset();
+    root = addNode(0, 0);
 
-        // push back into priority queue
-        pq.push(combined);
+    for (int i = 0; i < 256; i++) {
+        if (limited[i].length == 0) continue;
+
+        // follow the codeword from the root, adding missing nodes on the way
+        uint16_t curr = root;
+        nodes[curr].count += freqs[i];
+        for (unsigned int bit = limited[i].length; bit > 0; bit--) {
+            bool isOne = (limited[i].bits >> (bit - 1)) & 1;
+            uint16_t child = isOne ? nodes[curr].c1 : nodes[curr].c0;
+            if (child == NO_NODE) {
+                child = addNode(0, (byte)i);
+                nodes[child].p = curr;
+                if (isOne)
+                    nodes[curr].c1 = child;
+                else
+                    nodes[curr].c0 = child;
+            }
+            curr = child;
+            nodes[curr].count += freqs[i];
+        }
     }
 
-    // priority queue only has 1 element left, set to root
-    root = pq.top();
+    // the root takes its symbol from its 'c0' child like every parent
+    nodes[root].symbol = nodes[nodes[root].c0].symbol;
+    buildCodes(root, 0, 0);
+}
+
+/**
+ * Walk the subtree rooted at curr, whose path from the root is the given
+ * codeword, and record the codeword of every leaf in the code table. This
+ * runs once per build so encode() can do a single lookup per symbol.
+ */
+void HCTree::buildCodes(uint16_t curr, uint64_t bits, unsigned int length) {
+    if (curr == NO_NODE) return;
+
+    // leaf node, record its codeword
+    if (nodes[curr].isLeaf()) {
+        leaves[nodes[curr].symbol] = curr;
+        codes[nodes[curr].symbol] = HCCode(bits, length);
+        return;
+    }
+
+    buildCodes(nodes[curr].c0, bits << 1, length + 1);
+    buildCodes(nodes[curr].c1, (bits << 1) | 1, length + 1);
 }
 
 /**
@@ -108,43 +295,36 @@ void HCTree::build(const vector<unsigned int>& freqs) {
  * to create the HCTree.
  */
 
-// struct to find element in a vector of pointers
-struct getSymbol {
-    unsigned char symbol;
-
-    getSymbol(unsigned char _symbol) : symbol(_symbol) {}
-
-    bool operator()(const HCNode* node) const {
-        if (node == nullptr) return false;
-
-        return node->symbol == symbol;
-    }
-};
-
 void HCTree::encode(byte symbol, BitOutputStream& out) const {
-    // get leaf, then traverse up tree until hit root, adding '0' or
-    // '1' to a stack depending if left/right child
-    HCNode* prev = leaves->at(symbol);
-    HCNode* curr = prev->p;
-    stack<unsigned int> stack;
-
-    while (curr != nullptr) {
-        if (curr->c0 == prev)
-            stack.push(0);
-        else
-            stack.push(1);
+    // look up the codeword built by build() and write it with one call
+    const HCCode& code = codes[symbol];
+    out.writeBits(code.bits, code.length);
+}
+
+/**
+ * Reference version of encode() that finds the codeword by walking from the
+ * symbol's leaf up to the root instead of using the code table.
+ */
+void HCTree::encodeFromLeaf(byte symbol, BitOutputStream& out) const {
+    // get leaf, then traverse up tree until hit root, setting a '0' or '1'
+    // bit in the codeword depending if left/right child. Bits are collected
+    // from the least significant end, so the codeword comes out in root to
+    // leaf order without reversing it.
+    uint16_t prev = leaves[symbol];
+    uint16_t curr = nodes[prev].p;
+    uint64_t code = 0;
+    unsigned int length = 0;
+
+    while (curr != NO_NODE) {
+        if (nodes[curr].c1 == prev) code |= uint64_t(1) << length;
+        length++;
 
         prev = curr;
-        curr = curr->p;
+        curr = nodes[curr].p;
     }
 
-    // pop all from stack to reveal encoded letter in correct order
-    // push results to outstream
-    while (!stack.empty()) {
-        out.writeBit(stack.top());
-        stack.pop();
-        // out.printBuf();
-    }
+    // write the whole codeword with one call
+    out.writeBits(code, length);
 }
 
 /**
@@ -157,35 +337,11 @@ void HCTree::encode(byte symbol, BitOutputStream& out) const {
  */
 
 void HCTree::encode(byte symbol, ostream& out) const {
-    /*
-    // huffman tree should have been built by now, as well as leaves vector
-    // check if symbol exists (is a leaf/in leaves vector)
-    if (find_if(leaves->begin(), leaves->end(), getSymbol(symbol)) ==
-        leaves->end())
-        return;
-    */
-
-    // get leaf, then traverse up tree until hit root, adding '0' or
-    // '1' to a stack depending if left/right child
-    HCNode* prev = leaves->at(symbol);
-    HCNode* curr = prev->p;
-    stack<unsigned char> stack;
-
-    while (curr != nullptr) {
-        if (curr->c0 == prev)
-            stack.push('0');
-        else
-            stack.push('1');
-
-        prev = curr;
-        curr = curr->p;
-    }
-
-    // pop all from stack to reveal encoded letter in correct order
-    // push results to outstream
-    while (!stack.empty()) {
-        out.write((char*)&stack.top(), 1);
-        stack.pop();
+    // write each bit of the codeword from the code table as '0' or '1'
+    const HCCode& code = codes[symbol];
+    for (unsigned int i = code.length; i > 0; i--) {
+        char c = ((code.bits >> (i - 1)) & 1) ? '1' : '0';
+        out.write(&c, 1);
     }
 }
 
@@ -199,7 +355,7 @@ byte HCTree::decode(BitInputStream& in) const {
     // if (root == nullptr) return '\0';
 
     unsigned int i;
-    HCNode* curr = root;
+    uint16_t curr = root;
 
     // keep reading in from stream, until eof
     while (1) {
@@ -207,14 +363,14 @@ byte HCTree::decode(BitInputStream& in) const {
         i = in.readBit();
 
         // if '0', traverse left
-        if (i == 0) curr = curr->c0;
+        if (i == 0) curr = nodes[curr].c0;
         // else, traverse right
         else
-            curr = curr->c1;
+            curr = nodes[curr].c1;
 
         // if leaf node, found letter and return (stops at first leaf node
         // found)
-        if (curr->c0 == nullptr && curr->c1 == nullptr) return curr->symbol;
+        if (nodes[curr].isLeaf()) return nodes[curr].symbol;
     }
 }
 
@@ -228,7 +384,7 @@ byte HCTree::decode(istream& in) const {
     // if (root == nullptr) return '\0';
 
     unsigned char c;
-    HCNode* curr = root;
+    uint16_t curr = root;
 
     // keep reading in from stream, until eof
     while (1) {
@@ -236,14 +392,14 @@ byte HCTree::decode(istream& in) const {
         c = (unsigned char)in.get();
 
         // if '0', traverse left
-        if (c == '0') curr = curr->c0;
+        if (c == '0') curr = nodes[curr].c0;
         // else, traverse right
         else
-            curr = curr->c1;
+            curr = nodes[curr].c1;
 
         // if leaf node, found letter and return (stops at first leaf node
         // found)
-        if (curr->c0 == nullptr && curr->c1 == nullptr) return curr->symbol;
+        if (nodes[curr].isLeaf()) return nodes[curr].symbol;
     }
 }
 
@@ -4,37 +4,117 @@
 #include <algorithm>
 #include <fstream>
 #include <queue>
-#include <stack>
 #include <vector>
 #include "../bitStream/input/BitInputStream.hpp"
 #include "../bitStream/output/BitOutputStream.hpp"
+#include "HCCode.hpp"
 #include "HCNode.hpp"
 
 using namespace std;
 
+/** A Huffman coding tree. All nodes live in one contiguous array and refer
+ * to each other by 16-bit index, which is plenty since a tree over a byte
+ * alphabet has at most 511 nodes. Building, walking and tearing down the
+ * tree touch a few cache lines instead of hundreds of separate allocations.
+ */
 class HCTree {
+  public:
+    /* Index used for a missing child or parent */
+    static const uint16_t NO_NODE = 0xFFFF;
+
+    /* Most nodes a tree over a byte alphabet can have */
+    static const unsigned int MAX_NODES = 511;
+
   private:
-    HCNode* root;             // the root of HCTree
-    vector<HCNode*>* leaves;  // a vector storing pointers to all leaf HCNodes
+    /* A node of the tree, children and parent are indices into nodes */
+    struct Node {
+        unsigned int count;  // the freqency of the symbol
+        byte symbol;         // byte in the file we're keeping track of
+        uint16_t c0;         // index of '0' child
+        uint16_t c1;         // index of '1' child
+        uint16_t p;          // index of parent
 
-  public:
-    /* TODO: Initializes a new empty HCTree.*/
-    HCTree() {
-        root = nullptr;
-        leaves = new vector<HCNode*>(256);
+        Node(unsigned int count, byte symbol, uint16_t c0 = NO_NODE,
+             uint16_t c1 = NO_NODE, uint16_t p = NO_NODE)
+            : count(count), symbol(symbol), c0(c0), c1(c1), p(p) {}
+
+        bool isLeaf() const { return c0 == NO_NODE && c1 == NO_NODE; }
+    };
+
+    /* Priority queue order of node indices, same tie-breaking rules as
+     * HCNodePtrComp */
+    struct NodeComp {
+        const vector<Node>* nodes;
+        bool operator()(uint16_t lhs, uint16_t rhs) const {
+            const Node& l = (*nodes)[lhs];
+            const Node& r = (*nodes)[rhs];
+            if (l.count != r.count) return l.count > r.count;
+            return l.symbol < r.symbol;
+        }
+    };
+
+    vector<Node> nodes;        // every node of the tree
+    uint16_t root;             // index of the root of HCTree
+    vector<uint16_t> leaves;   // index of the leaf of every symbol
+    vector<HCCode> codes;      // codeword of every symbol, indexed by symbol
+
+    // add a node to the array and return its index
+    uint16_t addNode(unsigned int count, byte symbol) {
+        nodes.push_back(Node(count, symbol));
+        return nodes.size() - 1;
     }
 
-    HCTree(HCNode* _root) { root = _root; }
+    // copy a pointer based tree into the array, returning its root index
+    uint16_t addNodes(HCNode* curr, uint16_t parent);
+
+    // start over from an empty node array
+    void reset();
+
+    // make a new parent of the two nodes and return its index
+    uint16_t combine(uint16_t smaller, uint16_t larger);
 
-    ~HCTree();
+    // make the root a parent whose only child is node
+    void addRootAbove(uint16_t node);
 
-    // helper method for destructor
+    // fill the code table and apply the code length limit
+    void finishBuild(const vector<unsigned int>& freqs,
+                     unsigned int maxCodeLength);
+
+    // fill the leaves vector and code table from the subtree at curr
+    void buildCodes(uint16_t curr, uint64_t bits, unsigned int length);
+
+    // replace the tree with one built from length-limited canonical codes
+    void buildLimited(const vector<unsigned int>& freqs,
+                      unsigned int maxCodeLength);
+
+  public:
+    /* TODO: Initializes a new empty HCTree.*/
+    HCTree() : root(NO_NODE), leaves(256, NO_NODE), codes(256) {}
+
+    /* Make a tree from linked HCNodes. The nodes are copied into the node
+     * array and then deleted, so the HCTree owns them like before */
+    HCTree(HCNode* _root) : root(NO_NODE), leaves(256, NO_NODE), codes(256) {
+        root = addNodes(_root, NO_NODE);
+        deleteHCNode(_root);
+        buildCodes(root, 0, 0);
+    }
+
+    // delete a tree of linked HCNodes
     void static deleteHCNode(HCNode* curr);
 
-    void build(const vector<unsigned int>& freqs);
+    void build(const vector<unsigned int>& freqs,
+               unsigned int maxCodeLength = 0);
+
+    void buildWithPQ(const vector<unsigned int>& freqs,
+                     unsigned int maxCodeLength = 0);
 
     void encode(byte symbol, BitOutputStream& out) const;
 
+    void encodeFromLeaf(byte symbol, BitOutputStream& out) const;
+
+    /* Return the code table built by build(), indexed by symbol */
+    const vector<HCCode>& getCodes() const { return codes; }
+
     void encode(byte symbol, ostream& out) const;
 
     byte decode(BitInputStream& in) const;
@@ -0,0 +1,132 @@
+#include "Histogram.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HISTOGRAM_X86 1
+#endif
+
+// number of interleaved count tables
+const int NUM_TABLES = 4;
+
+/* Count tables that are merged into freqs once the kernel is done */
+struct CountTables {
+    uint32_t counts[NUM_TABLES][256];
+
+    CountTables() { memset(counts, 0, sizeof(counts)); }
+
+    // count the 8 bytes of a word, two to each table
+    void addWord(uint64_t word) {
+        counts[0][word & 0xFF]++;
+        counts[1][(word >> 8) & 0xFF]++;
+        counts[2][(word >> 16) & 0xFF]++;
+        counts[3][(word >> 24) & 0xFF]++;
+        counts[0][(word >> 32) & 0xFF]++;
+        counts[1][(word >> 40) & 0xFF]++;
+        counts[2][(word >> 48) & 0xFF]++;
+        counts[3][word >> 56]++;
+    }
+
+    // count 16 bytes
+    void add16(const byte* data) {
+        uint64_t first, second;
+        memcpy(&first, data, 8);
+        memcpy(&second, data + 8, 8);
+        addWord(first);
+        addWord(second);
+    }
+
+    // count the leftover bytes one at a time
+    void addTail(const byte* data, size_t n) {
+        for (size_t i = 0; i < n; i++) counts[i % NUM_TABLES][data[i]]++;
+    }
+
+    void mergeInto(vector<unsigned int>& freqs) const {
+        for (int i = 0; i < 256; i++) {
+            for (int t = 0; t < NUM_TABLES; t++) freqs[i] += counts[t][i];
+        }
+    }
+};
+
+void Histogram::countScalar(const byte* data, size_t n,
+                            vector<unsigned int>& freqs) {
+    CountTables tables;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) tables.add16(data + i);
+    tables.addTail(data + i, n - i);
+    tables.mergeInto(freqs);
+}
+
+#ifdef HISTOGRAM_X86
+
+void Histogram::countSSE2(const byte* data, size_t n,
+                          vector<unsigned int>& freqs) {
+    CountTables tables;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // a chunk of one repeated byte is counted in one step
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i first = _mm_set1_epi8((char)data[i]);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, first)) == 0xFFFF) {
+            tables.counts[0][data[i]] += 16;
+            continue;
+        }
+        tables.add16(data + i);
+    }
+    tables.addTail(data + i, n - i);
+    tables.mergeInto(freqs);
+}
+
+__attribute__((target("avx2"))) void Histogram::countAVX2(
+    const byte* data, size_t n, vector<unsigned int>& freqs) {
+    CountTables tables;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        // a chunk of one repeated byte is counted in one step
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i first = _mm256_set1_epi8((char)data[i]);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, first)) == -1) {
+            tables.counts[0][data[i]] += 32;
+            continue;
+        }
+        tables.add16(data + i);
+        tables.add16(data + i + 16);
+    }
+    tables.addTail(data + i, n - i);
+    tables.mergeInto(freqs);
+}
+
+bool Histogram::hasSSE2() { return __builtin_cpu_supports("sse2"); }
+
+bool Histogram::hasAVX2() { return __builtin_cpu_supports("avx2"); }
+
+#else
+
+// no SIMD kernels on other CPUs, fall back to the portable kernel
+void Histogram::countSSE2(const byte* data, size_t n,
+                          vector<unsigned int>& freqs) {
+    countScalar(data, n, freqs);
+}
+
+void Histogram::countAVX2(const byte* data, size_t n,
+                          vector<unsigned int>& freqs) {
+    countScalar(data, n, freqs);
+}
+
+bool Histogram::hasSSE2() { return false; }
+
+bool Histogram::hasAVX2() { return false; }
+
+#endif
+
+void Histogram::count(const byte* data, size_t n,
+                      vector<unsigned int>& freqs) {
+    // pick the kernel once, on the first call
+    typedef void (*Kernel)(const byte*, size_t, vector<unsigned int>&);
+    static const Kernel kernel = hasAVX2()   ? countAVX2
+                                 : hasSSE2() ? countSSE2
+                                             : countScalar;
+    kernel(data, n, freqs);
+}
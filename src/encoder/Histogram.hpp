@@ -0,0 +1,40 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <cstddef>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** Byte frequency counting for building Huffman trees. A plain freqs[c]++
+ * loop stalls on repeated bytes, since every increment of the same counter
+ * has to wait for the previous one. These kernels spread consecutive bytes
+ * over 4 separate count tables and merge them at the end. The SIMD kernels
+ * also spot chunks that are one byte repeated and count them in one step.
+ */
+class Histogram {
+  public:
+    /* Add the counts of the n bytes at data to freqs (which has 256
+     * entries), using the fastest kernel this CPU supports */
+    static void count(const byte* data, size_t n, vector<unsigned int>& freqs);
+
+    /* Portable kernel, 16 bytes per iteration */
+    static void countScalar(const byte* data, size_t n,
+                            vector<unsigned int>& freqs);
+
+    /* SSE2 kernel, 16 bytes per iteration */
+    static void countSSE2(const byte* data, size_t n,
+                          vector<unsigned int>& freqs);
+
+    /* AVX2 kernel, 32 bytes per iteration */
+    static void countAVX2(const byte* data, size_t n,
+                          vector<unsigned int>& freqs);
+
+    /* Whether the CPU can run the SSE2 and AVX2 kernels */
+    static bool hasSSE2();
+    static bool hasAVX2();
+};
+
+#endif  // HISTOGRAM_HPP
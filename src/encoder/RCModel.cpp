@@ -0,0 +1,126 @@
+#include "RCModel.hpp"
+
+#include <algorithm>
+
+const unsigned int RCModel::INCREMENT;
+const unsigned int RCModel::MAX_SEED;
+
+/* Weight of a byte's seed in an order-1 table, so every context learns its
+ * own frequencies quickly */
+const unsigned int ORDER1_SEED_SHIFT = 4;
+
+RCModel::RCModel(const vector<unsigned int>& seed, unsigned int order)
+    : order(order), tables(order == 0 ? 1 : 256), prev(0) {
+    vector<unsigned int> freqs(seed);
+    if (order != 0) {
+        unsigned int round = (1 << ORDER1_SEED_SHIFT) - 1;
+        for (unsigned int& freq : freqs) {
+            freq = (freq + round) >> ORDER1_SEED_SHIFT;
+        }
+    }
+    for (Table& table : tables) reset(table, freqs);
+}
+
+void RCModel::reset(Table& table, const vector<unsigned int>& freqs) {
+    table.freqs.assign(freqs.begin(), freqs.end());
+    table.tree.assign(257, 0);
+    table.total = 0;
+    for (int i = 1; i <= 256; i++) {
+        table.tree[i] += freqs[i - 1];
+        table.total += freqs[i - 1];
+        int parent = i + (i & -i);
+        if (parent <= 256) table.tree[parent] += table.tree[i];
+    }
+}
+
+uint32_t RCModel::cumFreq(const Table& table, byte symbol) {
+    uint32_t sum = 0;
+    for (int i = symbol; i > 0; i -= i & -i) sum += table.tree[i];
+    return sum;
+}
+
+void RCModel::update(Table& table, byte symbol) {
+    table.freqs[symbol] += INCREMENT;
+    table.total += INCREMENT;
+    if (table.total > RangeEncoder::MAX_TOTAL) {
+        // halve, rounding up so no used byte drops to 0
+        vector<unsigned int> halved(256);
+        for (int i = 0; i < 256; i++) {
+            halved[i] = (table.freqs[i] + 1) / 2;
+        }
+        reset(table, halved);
+        return;
+    }
+    for (int i = symbol + 1; i <= 256; i += i & -i) {
+        table.tree[i] += INCREMENT;
+    }
+}
+
+vector<unsigned int> RCModel::makeSeed(const vector<unsigned int>& freqs) {
+    unsigned int largest = *max_element(freqs.begin(), freqs.end());
+    vector<unsigned int> seed(256, 0);
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] == 0) continue;
+        seed[i] = max(uint64_t(1), uint64_t(freqs[i]) * MAX_SEED / largest);
+    }
+    return seed;
+}
+
+void RCModel::writeHeader(ostream& out, const vector<unsigned int>& seed,
+                          unsigned int order) {
+    unsigned int numSymbols = 0;
+    for (int i = 0; i < 256; i++) numSymbols += seed[i] != 0;
+
+    out.put((char)order);
+    out.put((char)numSymbols);
+    out.put((char)(numSymbols >> 8));
+    for (int i = 0; i < 256; i++) {
+        if (seed[i] == 0) continue;
+        out.put((char)i);
+        out.put((char)seed[i]);
+    }
+}
+
+bool RCModel::readHeader(istream& in, vector<unsigned int>& seed,
+                         unsigned int& order) {
+    seed.assign(256, 0);
+    order = (byte)in.get();
+    unsigned int numSymbols = (byte)in.get();
+    numSymbols |= (byte)in.get() << 8;
+    if (order > 1 || numSymbols > 256) return false;
+
+    for (unsigned int i = 0; i < numSymbols; i++) {
+        byte symbol = in.get();
+        seed[symbol] = (byte)in.get();
+        if (seed[symbol] == 0) return false;
+    }
+    return in.good();
+}
+
+void RCModel::encode(byte symbol, RangeEncoder& out) {
+    Table& table = tables[order == 0 ? 0 : prev];
+    out.encode(cumFreq(table, symbol), table.freqs[symbol], table.total);
+    update(table, symbol);
+    prev = symbol;
+}
+
+byte RCModel::decode(RangeDecoder& in) {
+    Table& table = tables[order == 0 ? 0 : prev];
+    uint32_t count = in.getFreq(table.total);
+
+    // walk down the tree to the byte whose share holds count
+    uint32_t rest = count;
+    int pos = 0;
+    for (int step = 128; step > 0; step >>= 1) {
+        if (table.tree[pos + step] <= rest) {
+            pos += step;
+            rest -= table.tree[pos];
+        }
+    }
+    byte symbol = pos;
+
+    in.decode(count - rest, table.freqs[symbol]);
+    update(table, symbol);
+    prev = symbol;
+    return symbol;
+}
@@ -0,0 +1,78 @@
+#ifndef RCMODEL_HPP
+#define RCMODEL_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "RangeCoder.hpp"
+
+using namespace std;
+
+/** Adaptive byte frequencies for the range coder. An order-0 model keeps
+ * one frequency table for the whole input, an order-1 model keeps one per
+ * value of the previous byte, so it learns which bytes follow which.
+ *
+ * Every table starts from a seed built from the byte histogram of the
+ * whole input, so the coder doesn't start out knowing nothing, and bytes
+ * that never occur get no share of the range at all. After every byte its
+ * frequency goes up by INCREMENT, and a table is halved once its total
+ * passes RangeEncoder::MAX_TOTAL, so recent bytes weigh more.
+ *
+ * The frequencies are kept in a Fenwick tree, which gives the cumulative
+ * frequency of a byte and finds the byte at a cumulative frequency in 8
+ * steps each.
+ */
+class RCModel {
+  public:
+    /* Frequency added to a byte every time it is coded */
+    static const unsigned int INCREMENT = 24;
+
+    /* Largest seed weight, which fits in a byte */
+    static const unsigned int MAX_SEED = 255;
+
+  private:
+    /* The frequencies of one context */
+    struct Table {
+        vector<uint32_t> freqs;  // frequency of every byte
+        vector<uint32_t> tree;   // Fenwick tree over freqs, 1-based
+        uint32_t total;          // sum of freqs
+    };
+
+    unsigned int order;    // 0 or 1
+    vector<Table> tables;  // one table, or one per previous byte
+    byte prev;             // previous byte, the context of order 1
+
+    // set every frequency of table and rebuild its tree
+    static void reset(Table& table, const vector<unsigned int>& freqs);
+
+    // sum of the frequencies of the bytes below symbol
+    static uint32_t cumFreq(const Table& table, byte symbol);
+
+    // count one more symbol, halving the table if it gets too big
+    static void update(Table& table, byte symbol);
+
+  public:
+    /* Start every table from seed, as made by makeSeed() */
+    RCModel(const vector<unsigned int>& seed, unsigned int order);
+
+    /* Scale a byte histogram to seed weights of 0 to MAX_SEED, keeping
+     * every used byte at 1 or more */
+    static vector<unsigned int> makeSeed(const vector<unsigned int>& freqs);
+
+    /* Write the order and seed, which is all a decoder needs to start from
+     * the same model */
+    static void writeHeader(ostream& out, const vector<unsigned int>& seed,
+                            unsigned int order);
+
+    /* Read a header written by writeHeader, false if it is damaged */
+    static bool readHeader(istream& in, vector<unsigned int>& seed,
+                           unsigned int& order);
+
+    /* Code symbol, which must have a seed weight, then update the model */
+    void encode(byte symbol, RangeEncoder& out);
+
+    /* Decode a symbol coded by encode() and update the model the same way */
+    byte decode(RangeDecoder& in);
+};
+
+#endif  // RCMODEL_HPP
@@ -0,0 +1,43 @@
+#include "RangeCoder.hpp"
+
+const uint32_t RangeEncoder::MAX_TOTAL;
+
+void RangeEncoder::shiftLow() {
+    // the top byte is final once no carry can reach it: either it is below
+    // 0xFF, or a carry just came in
+    if ((uint32_t)low < 0xFF000000 || (low >> 32) != 0) {
+        byte carry = low >> 32;
+        byte temp = cache;
+        do {
+            buffer.push_back(temp + carry);
+            temp = 0xFF;
+        } while (--cacheSize != 0);
+        cache = (low >> 24) & 0xFF;
+
+        if (buffer.size() >= bufSize) {
+            out.write((const char*)buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    }
+    cacheSize++;
+    low = (low & 0x00FFFFFF) << 8;
+}
+
+void RangeEncoder::flush() {
+    // every byte of low, so the decoder can read ahead of the last symbol
+    for (int i = 0; i < 5; i++) shiftLow();
+    out.write((const char*)buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+RangeDecoder::RangeDecoder(istream& is, size_t bufSize)
+    : in(is),
+      bufPos(0),
+      bufLen(0),
+      code(0),
+      range(0xFFFFFFFF),
+      pastEnd(0) {
+    buffer.resize(bufSize == 0 ? 1 : bufSize);
+    // the first byte is the encoder's initial cache, always 0
+    for (int i = 0; i < 5; i++) code = (code << 8) | nextByte();
+}
@@ -0,0 +1,122 @@
+#ifndef RANGECODER_HPP
+#define RANGECODER_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** The encoding side of a range coder. A symbol with frequency freq out of
+ * total, and cumFreq for the symbols before it, narrows the range to that
+ * share of it, so a symbol costs log2(total / freq) bits with no rounding
+ * to whole bits. The range is kept at 32 bits and shifted out a byte at a
+ * time; a carry into bytes already shifted out is resolved with a cached
+ * byte and a count of 0xFF bytes after it (as in LZMA).
+ *
+ * total must be at most MAX_TOTAL so every share of the range is wide
+ * enough to tell the symbols apart.
+ */
+class RangeEncoder {
+  public:
+    /* Largest total frequency a symbol may be coded with */
+    static const uint32_t MAX_TOTAL = 1 << 16;
+
+  private:
+    ostream& out;         // reference to the output stream to use
+    vector<byte> buffer;  // coded bytes waiting to be written to out
+    size_t bufSize;       // number of bytes to collect before writing
+    uint64_t low;         // bottom of the range, with a carry in bit 32
+    uint32_t range;       // width of the range
+    byte cache;           // last byte shifted out, may still get a carry
+    uint64_t cacheSize;   // cached byte plus the 0xFF bytes after it
+
+    // move the top byte of low out, holding it back while a carry can
+    // still reach it
+    void shiftLow();
+
+  public:
+    explicit RangeEncoder(ostream& os, size_t bufSize = 1 << 16)
+        : out(os),
+          bufSize(bufSize == 0 ? 1 : bufSize),
+          low(0),
+          range(0xFFFFFFFF),
+          cache(0),
+          cacheSize(1) {
+        buffer.reserve(this->bufSize);
+    }
+
+    /* Code a symbol taking [cumFreq, cumFreq + freq) out of total */
+    void encode(uint32_t cumFreq, uint32_t freq, uint32_t total) {
+        range /= total;
+        low += (uint64_t)cumFreq * range;
+        range *= freq;
+        while (range < (1 << 24)) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+    /* Write out the rest of the range and every buffered byte */
+    void flush();
+};
+
+/** The decoding side of RangeEncoder. getFreq() tells where in [0, total)
+ * the next symbol lies, the caller finds the symbol at that frequency, and
+ * decode() removes it with the same cumFreq and freq the encoder used.
+ * Past the end of the input, 0s are read. The decoder reads exactly the
+ * bytes the encoder wrote, so reading past the end means more symbols were
+ * decoded than coded.
+ */
+class RangeDecoder {
+  private:
+    istream& in;          // reference to the input stream to use
+    vector<byte> buffer;  // block of bytes read from in
+    size_t bufPos;        // index of the next unused byte in buffer
+    size_t bufLen;        // number of valid bytes in buffer
+    uint32_t code;        // coded value, relative to the bottom of range
+    uint32_t range;       // width of the range
+    uint64_t pastEnd;     // number of 0s read past the end of the input
+
+    byte nextByte() {
+        if (bufPos == bufLen) {
+            in.read((char*)buffer.data(), buffer.size());
+            bufLen = in.gcount();
+            bufPos = 0;
+            if (bufLen == 0) {
+                pastEnd++;
+                return 0;
+            }
+        }
+        return buffer[bufPos++];
+    }
+
+  public:
+    explicit RangeDecoder(istream& is, size_t bufSize = 1 << 16);
+
+    /* Frequency in [0, total) the next symbol covers */
+    uint32_t getFreq(uint32_t total) {
+        range /= total;
+        uint32_t freq = code / range;
+        // only a damaged stream can point past the end
+        return freq < total ? freq : total - 1;
+    }
+
+    /* Whether the decoder has read past the end of the input, so the
+     * symbols since then weren't coded (the input is damaged or cut short) */
+    bool isExhausted() const { return pastEnd > 0; }
+
+    /* Remove the symbol found with getFreq() */
+    void decode(uint32_t cumFreq, uint32_t freq) {
+        code -= cumFreq * range;
+        range *= freq;
+        while (range < (1 << 24)) {
+            code = (code << 8) | nextByte();
+            range <<= 8;
+        }
+    }
+};
+
+#endif  // RANGECODER_HPP
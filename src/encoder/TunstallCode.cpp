@@ -0,0 +1,197 @@
+#include "TunstallCode.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+const unsigned int TunstallCode::DEFAULT_CODE_BITS;
+const unsigned int TunstallCode::MIN_CODE_BITS;
+const unsigned int TunstallCode::MAX_CODE_BITS;
+const unsigned int TunstallCode::MAX_STRING_LENGTH;
+const unsigned int TunstallCode::FREQ_TOTAL;
+
+/* Marks a child that is a leaf, the rest of the value is its codeword */
+const uint32_t LEAF = uint32_t(1) << 31;
+
+/* Weight of the root, a child's weight is its parent's times its symbol's
+ * frequency over FREQ_TOTAL, which keeps every product within 64 bits */
+const uint64_t ROOT_WEIGHT = uint64_t(1) << 47;
+
+/* Bytes every string copy moves, strings is padded to allow it */
+const unsigned int COPY_BYTES = 16;
+
+vector<unsigned int> TunstallCode::normalize(
+    const vector<unsigned int>& counts) {
+    vector<unsigned int> scaled(256, 0);
+    uint64_t total = 0;
+    for (int i = 0; i < 256; i++) total += counts[i];
+    if (total == 0) return scaled;
+
+    // every used symbol keeps at least 1, the largest absorbs the rounding
+    uint64_t sum = 0;
+    int largest = 0;
+    for (int i = 0; i < 256; i++) {
+        if (counts[i] == 0) continue;
+        scaled[i] =
+            max(uint64_t(1), uint64_t(counts[i]) * FREQ_TOTAL / total);
+        sum += scaled[i];
+        if (scaled[i] > scaled[largest]) largest = i;
+    }
+    scaled[largest] += FREQ_TOTAL;
+    scaled[largest] -= sum;
+    return scaled;
+}
+
+TunstallCode::TunstallCode(const vector<unsigned int>& counts,
+                           unsigned int codeBits)
+    : codeBits(max(MIN_CODE_BITS, min(codeBits, MAX_CODE_BITS))),
+      alphabetSize(0),
+      freqs(normalize(counts)),
+      rank(256, 0) {
+    vector<byte> alphabet;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] == 0) continue;
+        rank[i] = alphabet.size();
+        alphabet.push_back(i);
+    }
+    alphabetSize = alphabet.size();
+    if (alphabetSize == 0) return;
+
+    // parse tree, the children of internal node k are the alphabetSize
+    // nodes from firstChild[k] on
+    struct Node {
+        uint64_t weight;
+        uint32_t parent;
+        int32_t internal;  // internal node number, -1 for a leaf
+        unsigned int depth;
+        byte symbol;
+    };
+    vector<Node> nodes(1, Node{ROOT_WEIGHT, 0, -1, 0, 0});
+    vector<uint32_t> firstChild;
+
+    // most probable leaf first, the lowest node index breaks ties
+    priority_queue<pair<uint64_t, int64_t>> leaves;
+    auto expand = [&](uint32_t node) {
+        nodes[node].internal = firstChild.size();
+        firstChild.push_back(nodes.size());
+        Node parent = nodes[node];
+        for (byte symbol : alphabet) {
+            uint64_t weight = parent.weight * freqs[symbol] / FREQ_TOTAL;
+            leaves.push(make_pair(weight, -(int64_t)nodes.size()));
+            nodes.push_back({weight, node, -1, parent.depth + 1, symbol});
+        }
+    };
+
+    expand(0);
+    size_t numLeaves = alphabetSize;
+    size_t maxLeaves = size_t(1) << this->codeBits;
+    while (!leaves.empty() && numLeaves + alphabetSize - 1 <= maxLeaves) {
+        uint32_t node = -leaves.top().second;
+        leaves.pop();
+        if (nodes[node].depth >= MAX_STRING_LENGTH) continue;
+        expand(node);
+        numLeaves += alphabetSize - 1;
+    }
+
+    // codewords go to the leaves in node order, every unused codeword
+    // decodes to an empty string
+    vector<uint32_t> leafCode(nodes.size());
+    entries.assign(maxLeaves, Entry{0, 0});
+    uint32_t code = 0;
+    for (uint32_t node = 1; node < nodes.size(); node++) {
+        if (nodes[node].internal >= 0) continue;
+        leafCode[node] = code;
+        entries[code].offset = strings.size();
+        entries[code].length = nodes[node].depth;
+        strings.resize(strings.size() + nodes[node].depth);
+        uint32_t pos = strings.size();
+        for (uint32_t curr = node; curr != 0; curr = nodes[curr].parent) {
+            strings[--pos] = nodes[curr].symbol;
+        }
+        code++;
+    }
+    strings.resize(strings.size() + COPY_BYTES);
+
+    children.resize(firstChild.size() * alphabetSize);
+    for (size_t k = 0; k < firstChild.size(); k++) {
+        for (unsigned int r = 0; r < alphabetSize; r++) {
+            const Node& child = nodes[firstChild[k] + r];
+            children[k * alphabetSize + r] =
+                child.internal >= 0 ? child.internal
+                                    : leafCode[firstChild[k] + r] | LEAF;
+        }
+    }
+}
+
+void TunstallCode::writeHeader(ostream& out) const {
+    out.put((char)codeBits);
+    out.put((char)alphabetSize);
+    out.put((char)(alphabetSize >> 8));
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] == 0) continue;
+        // frequencies are 1 to FREQ_TOTAL, store them minus 1 in 2 bytes
+        out.put((char)i);
+        out.put((char)(freqs[i] - 1));
+        out.put((char)((freqs[i] - 1) >> 8));
+    }
+}
+
+bool TunstallCode::readHeader(istream& in, vector<unsigned int>& freqs,
+                              unsigned int& codeBits) {
+    freqs.assign(256, 0);
+    codeBits = (byte)in.get();
+    unsigned int numSymbols = (byte)in.get();
+    numSymbols |= (byte)in.get() << 8;
+    if (codeBits < MIN_CODE_BITS || codeBits > MAX_CODE_BITS ||
+        numSymbols == 0 || numSymbols > 256) {
+        return false;
+    }
+
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < numSymbols; i++) {
+        byte symbol = in.get();
+        unsigned int freq = (byte)in.get();
+        freq |= (byte)in.get() << 8;
+        freqs[symbol] = freq + 1;
+        total += freq + 1;
+    }
+    return in.good() && total == FREQ_TOTAL;
+}
+
+void TunstallCode::encode(const byte* data, size_t n,
+                          BitOutputStream& out) const {
+    uint32_t node = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t next = children[node * alphabetSize + rank[data[i]]];
+        if (next & LEAF) {
+            out.writeBits(next & ~LEAF, codeBits);
+            node = 0;
+        } else {
+            node = next;
+        }
+    }
+
+    // the input ended inside a string, finish it with any leaf below it
+    if (node != 0) {
+        uint32_t next;
+        while (!((next = children[node * alphabetSize]) & LEAF)) node = next;
+        out.writeBits(next & ~LEAF, codeBits);
+    }
+}
+
+size_t TunstallCode::decode(BitInputStream& in, byte* out, size_t n) const {
+    size_t i = 0;
+    while (i < n) {
+        const Entry& e = entries[in.peekBits(codeBits)];
+        in.consumeBits(codeBits);
+
+        // most strings are short, one fixed size copy covers them
+        memcpy(out + i, &strings[e.offset], COPY_BYTES);
+        if (e.length > COPY_BYTES) {
+            memcpy(out + i + COPY_BYTES, &strings[e.offset + COPY_BYTES],
+                   e.length - COPY_BYTES);
+        }
+        i += e.length;
+    }
+    return i;
+}
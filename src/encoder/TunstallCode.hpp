@@ -0,0 +1,90 @@
+#ifndef TUNSTALLCODE_HPP
+#define TUNSTALLCODE_HPP
+
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "../bitStream/input/BitInputStream.hpp"
+#include "../bitStream/output/BitOutputStream.hpp"
+
+using namespace std;
+
+/** A Tunstall code, the variable-to-fixed counterpart of a Huffman code.
+ * The input is parsed into strings from a dictionary, and every string is
+ * sent as a codeword of the same codeBits bits. Decoding a codeword is a
+ * single table lookup and a string copy, with no codeword length to find.
+ *
+ * The dictionary is the set of leaves of a parse tree. It starts as one
+ * leaf per symbol of the alphabet, then the most probable leaf is expanded
+ * into one child per symbol for as long as the leaves fit in codeBits bits.
+ * The tree is built from normalized frequencies with integer arithmetic
+ * only, so the encoder and decoder always build the same tree.
+ */
+class TunstallCode {
+  public:
+    /* Default codeword width */
+    static const unsigned int DEFAULT_CODE_BITS = 12;
+
+    /* Range of codeword widths, there must be room for every symbol */
+    static const unsigned int MIN_CODE_BITS = 8;
+    static const unsigned int MAX_CODE_BITS = 16;
+
+    /* Longest string of the dictionary */
+    static const unsigned int MAX_STRING_LENGTH = 64;
+
+    /* Total of the normalized frequencies */
+    static const unsigned int FREQ_TOTAL = 1 << 16;
+
+  private:
+    /* A codeword's string, in strings */
+    struct Entry {
+        uint32_t offset;  // index of the first byte in strings
+        uint32_t length;  // number of bytes
+    };
+
+    unsigned int codeBits;       // width of every codeword
+    unsigned int alphabetSize;   // number of symbols with a frequency
+    vector<unsigned int> freqs;  // normalized frequencies, add to FREQ_TOTAL
+    vector<uint16_t> rank;       // index of every symbol in the alphabet
+
+    // child of every internal node, alphabetSize per node: a codeword with
+    // LEAF set, or the next internal node (the root is internal node 0)
+    vector<uint32_t> children;
+
+    vector<Entry> entries;  // string of every codeword
+    vector<byte> strings;   // all the strings, padded for fixed size copies
+
+  public:
+    /* Build the code for freqs (raw counts or normalized frequencies) */
+    explicit TunstallCode(const vector<unsigned int>& freqs,
+                          unsigned int codeBits = DEFAULT_CODE_BITS);
+
+    /* Scale freqs to add up to FREQ_TOTAL, keeping every used symbol */
+    static vector<unsigned int> normalize(const vector<unsigned int>& freqs);
+
+    /* Write codeBits and the normalized frequencies, which is all a decoder
+     * needs to build the same code */
+    void writeHeader(ostream& out) const;
+
+    /* Read a header written by writeHeader, false if it is damaged */
+    static bool readHeader(istream& in, vector<unsigned int>& freqs,
+                           unsigned int& codeBits);
+
+    unsigned int getCodeBits() const { return codeBits; }
+
+    /* Number of codewords in the dictionary */
+    size_t size() const { return entries.size(); }
+
+    /* Write the codewords of the n bytes at data. Every byte must have a
+     * frequency. The last string may be cut short, in which case the
+     * codeword of a longer string is sent and the decoder drops the rest */
+    void encode(const byte* data, size_t n, BitOutputStream& out) const;
+
+    /* Decode whole codewords into out until it holds at least n bytes, and
+     * return the number of bytes decoded. out must have room for
+     * n + MAX_STRING_LENGTH - 1 bytes. Codewords read past the end of a
+     * truncated input leave in.isExhausted() set */
+    size_t decode(BitInputStream& in, byte* out, size_t n) const;
+};
+
+#endif  // TUNSTALLCODE_HPP
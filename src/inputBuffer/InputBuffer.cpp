@@ -0,0 +1,62 @@
+#include "InputBuffer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
+/* Number of bytes read at a time from a file that can't be mapped */
+const size_t READ_CHUNK_SIZE = 1 << 16;
+
+InputBuffer::InputBuffer(const string& fileName)
+    : data(nullptr), length(0), mapped(nullptr), opened(false) {
+    if (!map(fileName)) read(fileName);
+}
+
+InputBuffer::~InputBuffer() {
+    if (mapped != nullptr) munmap(mapped, length);
+}
+
+bool InputBuffer::map(const string& fileName) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    // only non-empty regular files have a size worth mapping
+    struct stat info;
+    if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* region = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED) return false;
+
+    // the file is scanned front to back, let the kernel read ahead
+    madvise(region, info.st_size, MADV_SEQUENTIAL);
+
+    mapped = region;
+    data = (const byte*)region;
+    length = info.st_size;
+    opened = true;
+    return true;
+}
+
+void InputBuffer::read(const string& fileName) {
+    ifstream in(fileName, ios::binary);
+    if (!in.is_open()) return;
+
+    // size isn't known up front, so grow the buffer a chunk at a time
+    while (in) {
+        size_t oldSize = buffer.size();
+        buffer.resize(oldSize + READ_CHUNK_SIZE);
+        in.read((char*)buffer.data() + oldSize, READ_CHUNK_SIZE);
+        buffer.resize(oldSize + in.gcount());
+    }
+
+    data = buffer.data();
+    length = buffer.size();
+    opened = true;
+}
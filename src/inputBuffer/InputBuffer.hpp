@@ -0,0 +1,50 @@
+#ifndef INPUTBUFFER_HPP
+#define INPUTBUFFER_HPP
+
+#include <string>
+#include <vector>
+
+typedef unsigned char byte;
+
+using namespace std;
+
+/** The whole contents of an input file, held in memory so it can be scanned
+ * as many times as needed without going back to the file. Regular files are
+ * mapped into memory with mmap. Anything that can't be mapped (pipes, special
+ * files, empty files) is read once into a buffer.
+ */
+class InputBuffer {
+  private:
+    const byte* data;      // first byte of the file contents
+    size_t length;         // number of bytes in the file
+    void* mapped;          // start of the mmap'd region, or nullptr
+    vector<byte> buffer;   // file contents when the file isn't mapped
+    bool opened;           // whether the file could be opened
+
+    // try to map the file, returns false if it can't be mapped
+    bool map(const string& fileName);
+
+    // read the whole file into buffer
+    void read(const string& fileName);
+
+  public:
+    /* Open the file and map or read in its contents */
+    explicit InputBuffer(const string& fileName);
+
+    ~InputBuffer();
+
+    // the mapping can't be shared between copies
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+
+    /* Whether the file could be opened */
+    bool isOpen() const { return opened; }
+
+    /* Pointer to the file contents */
+    const byte* getData() const { return data; }
+
+    /* Number of bytes in the file */
+    size_t size() const { return length; }
+};
+
+#endif  // INPUTBUFFER_HPP
@@ -3,13 +3,27 @@
  *
  * Author: Darren Yau
  */
+#include <fcntl.h>
+#include <unistd.h>
 #include <cxxopts.hpp>
 #include <fstream>
 #include <iostream>
 
+#include "BlockCodec.hpp"
+#include "BlockDecompressor.hpp"
 #include "FileUtils.hpp"
+#include "HCAdaptiveTree.hpp"
+#include "HCCanonical.hpp"
+#include "HCDecodeTable.hpp"
+#include "HCMultiDecodeTable.hpp"
 #include "HCNode.hpp"
 #include "HCTree.hpp"
+#include "InputBuffer.hpp"
+#include "RCModel.hpp"
+#include "TunstallCode.hpp"
+
+/* Number of bytes read from or written to a file at a time */
+const size_t BIT_BUFFER_SIZE = 1 << 16;
 
 /* TODO: Pseudo decompression with ascii encoding and naive header (checkpoint)
  */
@@ -61,15 +75,27 @@ void pseudoDecompression(const string& inFileName, const string& outFileName) {
     }
 }
 
+/* Decode totalBytes symbols from bis with the lookup table, a buffer of
+ * symbols at a time, and write them to out */
+template <typename Table>
+void decodeSymbols(const Table& table, BitInputStream& bis, ostream& out,
+                   unsigned long long totalBytes) {
+    vector<byte> outBuf(BIT_BUFFER_SIZE);
+    while (totalBytes > 0) {
+        size_t n = min((unsigned long long)outBuf.size(), totalBytes);
+        table.decode(bis, outBuf.data(), n);
+        out.write((const char*)outBuf.data(), n);
+        totalBytes -= n;
+    }
+}
+
 /* TODO: True decompression with bitwise i/o and small header (final) */
 void trueDecompression(const string& inFileName, const string& outFileName) {
     ifstream in(inFileName, ios::binary);
     ofstream out;
 
     unsigned int frequency;
-    int totalBytes = 0;
-    unsigned char c;
-    unsigned int shiftAmt;
+    unsigned long long totalBytes = 0;
 
     // check if file opened successfully
     if (in.is_open()) {
@@ -81,7 +107,6 @@ void trueDecompression(const string& inFileName, const string& outFileName) {
         cout << "Reading from file header" << endl;
         for (int i = 0; i < freqs.size(); i++) {
             // read in each number
-            // in.read((char*)&frequency, sizeof(i));
             in >> frequency;
             // update freqs vector
             freqs[i] = frequency;
@@ -93,57 +118,439 @@ void trueDecompression(const string& inFileName, const string& outFileName) {
         tree.build(freqs);
         cout << "Done" << endl;
 
-        // start uncompression bit by bit
+        // start uncompression, decoding a block of symbols at a time through
+        // the lookup table. The padded 0s and the padding digit after the
+        // last byte are never decoded, since we stop after totalBytes symbols
+        out.open(outFileName, ios::binary);
+        BitInputStream bis(in, BIT_BUFFER_SIZE);
+
+        // with short codewords, decode several symbols per lookup
+        const vector<HCCode>& codes = tree.getCodes();
+        unsigned long long totalBits = 0;
+        for (int i = 0; i < 256; i++) {
+            totalBits += (unsigned long long)freqs[i] * codes[i].length;
+        }
+
+        cout << "Uncompressing" << endl;
+        if (totalBytes > 0 &&
+            HCMultiDecodeTable::paysOff((double)totalBits / totalBytes)) {
+            decodeSymbols(HCMultiDecodeTable(codes), bis, out, totalBytes);
+        } else {
+            decodeSymbols(HCDecodeTable(codes), bis, out, totalBytes);
+        }
+
+        cout << "Done" << endl;
+        in.close();
+        out.close();
+    }
+}
+
+/* Decompression of files written with canonical codes. The decode table is
+ * rebuilt straight from the code lengths in the header, without a tree */
+void canonicalDecompression(const string& inFileName,
+                            const string& outFileName) {
+    ifstream in(inFileName, ios::binary);
+    ofstream out;
+
+    // check if file opened successfully
+    if (in.is_open()) {
+        cout << "Reading from file header" << endl;
+        vector<unsigned int> lengths;
+        if (!HCCanonical::readLengths(in, lengths)) {
+            cout << "Invalid code length header. Please try again.\n";
+            return;
+        }
+        unsigned long long totalBytes = FileUtils::readInt(in, 8);
+
+        // every symbol takes at least the shortest codeword, so a count
+        // the rest of the file can't hold comes from a damaged header
+        unsigned int shortest = HCCanonical::MAX_LENGTH;
+        for (unsigned int length : lengths) {
+            if (length != 0) shortest = min(shortest, length);
+        }
+        streampos dataStart = in.tellg();
+        in.seekg(0, ios::end);
+        unsigned long long dataBytes = in.tellg() - dataStart;
+        in.seekg(dataStart);
+        if (!in.good() || totalBytes > dataBytes * 8 / shortest) {
+            cout << "Invalid symbol count in header. Please try again.\n";
+            return;
+        }
+
+        cout << "Building decode table" << endl;
+        HCDecodeTable table(HCCanonical::codesFromLengths(lengths));
+        cout << "Done" << endl;
+
         out.open(outFileName, ios::binary);
-        BitInputStream bis(in);
+        BitInputStream bis(in, BIT_BUFFER_SIZE);
 
         cout << "Uncompressing" << endl;
-        for (int i = 0; i < totalBytes; i++) {
-            // don't uncompress padded 0s
-            // totalBytes only represents encoded bytes, not
-            // padded 0s data appended to end
-            if (i == totalBytes - 1) {
-                c = (unsigned char)tree.decode(bis);
-                cout << "Last decoded char was: " << c << endl;
-                shiftAmt = (unsigned int)(in.get() - '0');
-                c >> shiftAmt;
-                cout << "After shift of " << shiftAmt << " is " << c << endl;
-                out << c;
+        decodeSymbols(table, bis, out, totalBytes);
+
+        cout << "Done" << endl;
+        in.close();
+        out.close();
+    }
+}
+
+/* Decode the blocks of a container with a block index on numThreads threads,
+ * writing every block to its place in the output file */
+void parallelBlockDecompression(const byte* data,
+                                const vector<BlockIndexEntry>& index,
+                                const string& outFileName,
+                                unsigned int numThreads,
+                                DecoderEngine engine) {
+    int fd = open(outFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, BlockDecompressor::rawSize(index)) != 0) {
+        cout << "Could not write " << outFileName << ". Please try again.\n";
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    cout << "Uncompressing blocks on " << numThreads << " threads" << endl;
+    vector<size_t> damaged =
+        BlockDecompressor::decodeToFile(data, index, fd, numThreads, engine);
+    for (size_t blockNum : damaged) {
+        cout << "Block " << blockNum << " is damaged, skipping it.\n";
+    }
+
+    cout << "Done" << endl;
+    close(fd);
+}
+
+/* Decompression of block container files. Blocks are decoded one at a time
+ * straight from the mapped input. A damaged block is reported and written
+ * as 0s, so the blocks after it still end up at the right offsets. With
+ * numThreads above 0, a container with a block index is handed to
+ * parallelBlockDecompression instead */
+void blockDecompression(const string& inFileName, const string& outFileName,
+                        unsigned int numThreads, DecoderEngine engine) {
+    InputBuffer in(inFileName);
+    ofstream out;
+
+    // check if file opened successfully
+    if (in.isOpen()) {
+        const byte* data = in.getData();
+        size_t size = in.size();
+        if (size < BLOCK_MAGIC_SIZE ||
+            memcmp(data, BLOCK_MAGIC, BLOCK_MAGIC_SIZE) != 0) {
+            cout << "Input is not a block container. Please try again.\n";
+            return;
+        }
+
+        // with an index, the blocks don't have to be decoded in order
+        vector<BlockIndexEntry> index;
+        if (numThreads > 0) {
+            if (BlockDecompressor::readIndex(data, size, index)) {
+                parallelBlockDecompression(data, index, outFileName,
+                                           numThreads, engine);
+                return;
+            }
+            cout << "No usable block index, uncompressing in order.\n";
+        }
+
+        out.open(outFileName, ios::binary);
+        cout << "Uncompressing blocks" << endl;
+        vector<byte> block;
+        size_t pos = BLOCK_MAGIC_SIZE;
+        for (size_t blockNum = 0;; blockNum++) {
+            if (size - pos < BLOCK_HEADER_SIZE) {
+                cout << "Block container is truncated.\n";
+                break;
+            }
+            BlockHeader header = BlockHeader::read(data + pos);
+            pos += BLOCK_HEADER_SIZE;
+            if (header.type == END_BLOCK) break;
+
+            // without a sane size there is no way to find the next block
+            if (header.payloadSize > size - pos ||
+                header.rawSize > MAX_BLOCK_SIZE) {
+                cout << "Block " << blockNum << " is damaged, stopping.\n";
                 break;
             }
-            c = (unsigned char)tree.decode(bis);
-            // cout << "Decoded char: " << c << endl;
-            out << c;
+
+            // stored bytes are written straight from the input
+            const byte* raw = BlockCodec::storedData(header, data + pos);
+            if (raw != nullptr) {
+                out.write((const char*)raw, header.rawSize);
+                pos += header.payloadSize;
+                continue;
+            }
+
+            block.resize(header.rawSize);
+            if (!BlockCodec::decodeBlock(header, data + pos, block.data(),
+                                         engine)) {
+                cout << "Block " << blockNum << " is damaged, skipping it.\n";
+                fill(block.begin(), block.end(), 0);
+            }
+            out.write((const char*)block.data(), block.size());
+            pos += header.payloadSize;
         }
 
         cout << "Done" << endl;
-        in.close();
         out.close();
     }
 }
 
+/* Uncompress a block container from a stream, reading one block at a time.
+ * The block index after the end block isn't needed and is never read */
+void streamDecompression(istream& in, ostream& out, DecoderEngine engine) {
+    char magic[BLOCK_MAGIC_SIZE];
+    in.read(magic, BLOCK_MAGIC_SIZE);
+    if (in.gcount() != (streamsize)BLOCK_MAGIC_SIZE ||
+        memcmp(magic, BLOCK_MAGIC, BLOCK_MAGIC_SIZE) != 0) {
+        cerr << "Input is not a block container. Please try again.\n";
+        return;
+    }
+
+    cerr << "Uncompressing blocks from stream" << endl;
+    byte headerBytes[BLOCK_HEADER_SIZE];
+    vector<byte> payload, block;
+    for (size_t blockNum = 0;; blockNum++) {
+        in.read((char*)headerBytes, BLOCK_HEADER_SIZE);
+        if (in.gcount() != (streamsize)BLOCK_HEADER_SIZE) {
+            cerr << "Block container is truncated.\n";
+            break;
+        }
+        BlockHeader header = BlockHeader::read(headerBytes);
+        if (header.type == END_BLOCK) break;
+
+        // without a sane size there is no way to find the next block
+        if (header.payloadSize > MAX_PAYLOAD_SIZE ||
+            header.rawSize > MAX_BLOCK_SIZE) {
+            cerr << "Block " << blockNum << " is damaged, stopping.\n";
+            break;
+        }
+
+        payload.resize(header.payloadSize);
+        in.read((char*)payload.data(), payload.size());
+        if (in.gcount() != (streamsize)payload.size()) {
+            cerr << "Block container is truncated.\n";
+            break;
+        }
+
+        const byte* raw = BlockCodec::storedData(header, payload.data());
+        if (raw != nullptr) {
+            out.write((const char*)raw, header.rawSize);
+            continue;
+        }
+
+        block.resize(header.rawSize);
+        if (!BlockCodec::decodeBlock(header, payload.data(), block.data(),
+                                     engine)) {
+            cerr << "Block " << blockNum << " is damaged, skipping it.\n";
+            fill(block.begin(), block.end(), 0);
+        }
+        out.write((const char*)block.data(), block.size());
+    }
+
+    cerr << "Done" << endl;
+}
+
+/* Uncompress a stream written by adaptiveCompression, updating the dynamic
+ * Huffman tree the same way the encoder did until END_SYMBOL. Decoded bytes
+ * go out as soon as their bits arrive */
+void adaptiveDecompression(istream& in, ostream& out) {
+    cerr << "Uncompressing with adaptive Huffman" << endl;
+    if (!HCAdaptiveTree::decodeStream(in, out)) {
+        cerr << "Adaptive Huffman data is truncated.\n";
+        return;
+    }
+    cerr << "Done" << endl;
+}
+
+/* Uncompress a stream written by tunstallCompression. The code is rebuilt
+ * from the frequencies in the header, then every codeword is copied out as
+ * a whole string; the bytes of a string that don't fit in the buffer are
+ * carried over to the next one */
+void tunstallDecompression(istream& in, ostream& out) {
+    cerr << "Uncompressing with a Tunstall code" << endl;
+    vector<unsigned int> freqs;
+    unsigned int codeBits;
+    if (!TunstallCode::readHeader(in, freqs, codeBits)) {
+        cerr << "Tunstall header is damaged.\n";
+        return;
+    }
+    unsigned long long totalBytes = FileUtils::readInt(in, 8);
+
+    // every codeword holds at most MAX_STRING_LENGTH bytes, so a count the
+    // rest of the file can't hold comes from a damaged header
+    streampos dataStart = in.tellg();
+    in.seekg(0, ios::end);
+    unsigned long long dataBytes = in.tellg() - dataStart;
+    in.seekg(dataStart);
+    if (!in.good() || totalBytes > dataBytes * 8 / codeBits *
+                                       TunstallCode::MAX_STRING_LENGTH) {
+        cerr << "Invalid byte count in header. Please try again.\n";
+        return;
+    }
+    TunstallCode code(freqs, codeBits);
+
+    BitInputStream bis(in, BIT_BUFFER_SIZE);
+    vector<byte> buffer(BIT_BUFFER_SIZE + TunstallCode::MAX_STRING_LENGTH);
+    size_t carried = 0;
+    while (totalBytes > 0) {
+        size_t n = min((unsigned long long)BIT_BUFFER_SIZE, totalBytes);
+        size_t decoded = carried;
+        if (carried < n) {
+            decoded += code.decode(bis, buffer.data() + carried, n - carried);
+        }
+        if (bis.isExhausted()) {
+            cerr << "Tunstall coded data is damaged or truncated.\n";
+            return;
+        }
+        out.write((const char*)buffer.data(), n);
+        totalBytes -= n;
+        carried = decoded - n;
+        copy(buffer.begin() + n, buffer.begin() + decoded, buffer.begin());
+    }
+    cerr << "Done" << endl;
+}
+
+/* Uncompress a stream written by rangeCompression, starting from the seeded
+ * model in the header and updating it the same way the encoder did. A byte
+ * count larger than the coded data (a damaged header) stops the decoding
+ * once the input runs out */
+void rangeDecompression(istream& in, ostream& out) {
+    cerr << "Uncompressing with a range coder" << endl;
+    vector<unsigned int> seed;
+    unsigned int order;
+    if (!RCModel::readHeader(in, seed, order)) {
+        cerr << "Range coder header is damaged.\n";
+        return;
+    }
+    unsigned long long totalBytes = FileUtils::readInt(in, 8);
+    RCModel model(seed, order);
+
+    RangeDecoder decoder(in, BIT_BUFFER_SIZE);
+    vector<byte> buffer(BIT_BUFFER_SIZE);
+    while (totalBytes > 0) {
+        size_t n = min((unsigned long long)buffer.size(), totalBytes);
+        for (size_t i = 0; i < n; i++) buffer[i] = model.decode(decoder);
+        if (decoder.isExhausted()) {
+            cerr << "Range coded data is damaged or truncated.\n";
+            return;
+        }
+        out.write((const char*)buffer.data(), n);
+        totalBytes -= n;
+    }
+    cerr << "Done" << endl;
+}
+
+/* Look up the decoder engine with the given name */
+bool parseDecoder(const string& name, DecoderEngine& engine) {
+    if (name == "auto") {
+        engine = AUTO_DECODER;
+    } else if (name == "table") {
+        engine = TABLE_DECODER;
+    } else if (name == "multi") {
+        engine = MULTI_DECODER;
+    } else if (name == "fsm") {
+        engine = FSM_DECODER;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 /* Main program that runs the decompression */
 int main(int argc, char* argv[]) {
     cxxopts::Options options(argv[0],
                              "Uncompresses files using Huffman Encoding");
     options.positional_help(
-        "./path_to_compressed_input_file ./path_to_output_file");
+        "./path_to_compressed_input_file ./path_to_output_file (- for "
+        "stdin/stdout streams a block container)");
 
     bool isAscii = false;
+    bool isCanonical = false;
+    bool isBlock = false;
+    unsigned int numThreads = 0;
+    string decoderName = "auto";
+    string engineName = "huffman";
     string inFileName, outFileName;
     options.allow_unrecognised_options().add_options()(
         "ascii", "Read input in ascii mode instead of bit stream",
-        cxxopts::value<bool>(isAscii))("input", "",
-                                       cxxopts::value<string>(inFileName))(
+        cxxopts::value<bool>(isAscii))(
+        "canonical", "Read input written with canonical codes",
+        cxxopts::value<bool>(isCanonical))(
+        "block", "Read input written as a block container",
+        cxxopts::value<bool>(isBlock))(
+        "threads",
+        "Number of threads decoding blocks at once (implies --block)",
+        cxxopts::value<unsigned int>(numThreads))(
+        "decoder",
+        "How to decode Huffman blocks: auto, table, multi (several symbols "
+        "per lookup) or fsm (a byte per lookup)",
+        cxxopts::value<string>(decoderName))(
+        "engine",
+        "Coding engine the input was written with: huffman, adaptive, "
+        "tunstall or range",
+        cxxopts::value<string>(engineName))(
+        "input", "", cxxopts::value<string>(inFileName))(
         "output", "", cxxopts::value<string>(outFileName))(
         "h,help", "Print help and exit.");
 
     options.parse_positional({"input", "output"});
     auto userOptions = options.parse(argc, argv);
 
-    if (userOptions.count("help") || !FileUtils::isValidFile(inFileName) ||
-        outFileName.empty()) {
-        cout << options.help({""}) << std::endl;
+    DecoderEngine decoder;
+    if (!parseDecoder(decoderName, decoder)) {
+        cerr << "Unknown decoder " << decoderName << ". Please try again.\n";
+        return 0;
+    }
+    bool isAdaptive = engineName == "adaptive";
+    bool isTunstall = engineName == "tunstall";
+    bool isRange = engineName == "range";
+    if (!isAdaptive && !isTunstall && !isRange && engineName != "huffman") {
+        cerr << "Unknown engine " << engineName << ". Please try again.\n";
+        return 0;
+    }
+
+    bool isStream = FileUtils::isStdStream(inFileName) ||
+                    FileUtils::isStdStream(outFileName);
+    if (userOptions.count("help") || outFileName.empty() ||
+        (!FileUtils::isStdStream(inFileName) &&
+         !FileUtils::isValidFile(inFileName))) {
+        // keep the help text out of a stream being piped on
+        (isStream ? cerr : cout) << options.help({""}) << std::endl;
+        return 0;
+    }
+
+    // stdin or stdout, stream a block container or one of the engines. The
+    // functions below report progress on cerr, since out may be stdout
+    if (isStream) {
+        // unsynced, cin reads what the pipe has instead of waiting for a
+        // full request, and can tell when the next read would wait
+        ios::sync_with_stdio(false);
+        ifstream inFile;
+        ofstream outFile;
+        if (!FileUtils::isStdStream(inFileName)) {
+            inFile.open(inFileName, ios::binary);
+            if (!inFile.is_open()) {
+                cerr << "Could not read " << inFileName
+                     << ". Please try again.\n";
+                return 0;
+            }
+        }
+        if (!FileUtils::isStdStream(outFileName)) {
+            outFile.open(outFileName, ios::binary);
+            if (!outFile.is_open()) {
+                cerr << "Could not write " << outFileName
+                     << ". Please try again.\n";
+                return 0;
+            }
+        }
+        istream& in = FileUtils::isStdStream(inFileName) ? cin : inFile;
+        ostream& out = FileUtils::isStdStream(outFileName) ? cout : outFile;
+        if (isAdaptive) {
+            adaptiveDecompression(in, out);
+        } else if (isTunstall) {
+            tunstallDecompression(in, out);
+        } else if (isRange) {
+            rangeDecompression(in, out);
+        } else {
+            streamDecompression(in, out, decoder);
+        }
         return 0;
     }
 
@@ -155,8 +562,24 @@ int main(int argc, char* argv[]) {
         return 0;
     }
 
-    if (isAscii) {
+    if (isAdaptive) {
+        ifstream in(inFileName, ios::binary);
+        ofstream out(outFileName, ios::binary);
+        adaptiveDecompression(in, out);
+    } else if (isTunstall) {
+        ifstream in(inFileName, ios::binary);
+        ofstream out(outFileName, ios::binary);
+        tunstallDecompression(in, out);
+    } else if (isRange) {
+        ifstream in(inFileName, ios::binary);
+        ofstream out(outFileName, ios::binary);
+        rangeDecompression(in, out);
+    } else if (isAscii) {
         pseudoDecompression(inFileName, outFileName);
+    } else if (isBlock || numThreads > 0) {
+        blockDecompression(inFileName, outFileName, numThreads, decoder);
+    } else if (isCanonical) {
+        canonicalDecompression(inFileName, outFileName);
     } else {
         trueDecompression(inFileName, outFileName);
     }
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ANSCoder.hpp"
+#include "Histogram.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Encode input with a coder built from its histogram and decode it again.
+ * Returns the payload size */
+static size_t checkRoundTrip(const vector<byte>& input,
+                             unsigned int tableLog) {
+    vector<unsigned int> freqs(256);
+    Histogram::count(input.data(), input.size(), freqs);
+    ANSCoder coder(tableLog);
+    coder.build(freqs);
+
+    vector<byte> payload;
+    coder.encode(input.data(), input.size(), payload);
+
+    // the estimate is within a fraction of a percent of the real size
+    EXPECT_LE(payload.size(), coder.encodedSize() * 1.005 + 8);
+    EXPECT_GE(payload.size() * 1.005 + 8, coder.encodedSize());
+
+    vector<byte> decoded(input.size());
+    EXPECT_TRUE(ANSCoder().decode(payload.data(), payload.size(),
+                                  decoded.data(), decoded.size()));
+    EXPECT_EQ(decoded, input);
+    return payload.size();
+}
+
+TEST(ANSCoderTests, TEST_NORMALIZE) {
+    vector<unsigned int> freqs(256, 0);
+    for (int i = 0; i < 200; i++) freqs[i] = 1;
+    freqs['z'] = 1000000;
+    vector<unsigned int> norm = ANSCoder::normalize(freqs, 8);
+
+    // every used symbol keeps at least 1, and they fill the table
+    unsigned int total = 0;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] > 0) {
+            ASSERT_GE(norm[i], 1u);
+        } else {
+            ASSERT_EQ(norm[i], 0u);
+        }
+        total += norm[i];
+    }
+    ASSERT_EQ(total, 256u);
+    ASSERT_EQ(norm['z'], 256u - 199);
+}
+
+TEST(ANSCoderTests, TEST_TEXT) {
+    string text = "fractional bits per symbol from a table of states";
+    checkRoundTrip(vector<byte>(text.begin(), text.end()),
+                   ANSCoder::DEFAULT_TABLE_LOG);
+}
+
+TEST(ANSCoderTests, TEST_ONE_SYMBOL) {
+    // the state never changes, so the bytes cost nothing
+    size_t size = checkRoundTrip(vector<byte>(100000, 'x'),
+                                 ANSCoder::DEFAULT_TABLE_LOG);
+    ASSERT_LE(size, 16u);
+}
+
+TEST(ANSCoderTests, TEST_SKEWED) {
+    // 2 symbols with p = 0.95 and 0.05 carry 0.29 bits per byte
+    srand(11);
+    vector<byte> input;
+    for (int i = 0; i < 100000; i++) input.push_back(rand() % 20 ? 'a' : 'b');
+    size_t size = checkRoundTrip(input, ANSCoder::DEFAULT_TABLE_LOG);
+    ASSERT_LT(size, 100000 * 0.30 / 8);
+}
+
+TEST(ANSCoderTests, TEST_ALL_SYMBOLS) {
+    srand(12);
+    vector<byte> input;
+    for (int i = 0; i < 256; i++) input.push_back(i);
+    for (int i = 0; i < 50000; i++) {
+        input.push_back(rand() % 256 & rand() % 256);
+    }
+    for (unsigned int tableLog = ANSCoder::MIN_TABLE_LOG;
+         tableLog <= ANSCoder::MAX_TABLE_LOG; tableLog++) {
+        checkRoundTrip(input, tableLog);
+    }
+}
+
+TEST(ANSCoderTests, TEST_DAMAGED_PAYLOAD) {
+    string text = "damaged tables are refused";
+    vector<unsigned int> freqs(256);
+    Histogram::count((const byte*)text.data(), text.size(), freqs);
+    ANSCoder coder;
+    coder.build(freqs);
+    vector<byte> payload;
+    coder.encode((const byte*)text.data(), text.size(), payload);
+    vector<byte> decoded(text.size());
+
+    // stream cut short
+    ASSERT_FALSE(ANSCoder().decode(payload.data(), payload.size() - 2,
+                                   decoded.data(), decoded.size()));
+
+    // table size out of range
+    vector<byte> badLog = payload;
+    badLog[0] = 20;
+    ASSERT_FALSE(ANSCoder().decode(badLog.data(), badLog.size(),
+                                   decoded.data(), decoded.size()));
+
+    // frequencies that don't fill the table
+    vector<byte> badFreq = payload;
+    badFreq[3]++;
+    ASSERT_FALSE(ANSCoder().decode(badFreq.data(), badFreq.size(),
+                                   decoded.data(), decoded.size()));
+}
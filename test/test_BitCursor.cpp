@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BitCursor.hpp"
+#include "BitInputStream.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(BitCursorTests, TEST_READ_BITS) {
+    byte data[] = {0xA5, 0x0F};
+    BitCursor cursor(data, sizeof(data));
+
+    ASSERT_EQ(cursor.readBits(1), 1);
+    ASSERT_EQ(cursor.readBits(3), 2);
+    ASSERT_EQ(cursor.peekBits(8), 0x50);
+    ASSERT_EQ(cursor.readBits(12), 0x50F);
+
+    // past the end only 0s are read
+    ASSERT_EQ(cursor.readBits(56), 0);
+}
+
+TEST(BitCursorTests, TEST_EMPTY) {
+    BitCursor cursor;
+    ASSERT_EQ(cursor.readBits(7), 0);
+}
+
+TEST(BitCursorTests, TEST_MATCHES_BIT_INPUT_STREAM) {
+    srand(16);
+    string bytes;
+    for (int i = 0; i < 1000; i++) bytes.push_back((char)rand());
+
+    BitCursor cursor((const byte*)bytes.data(), bytes.size());
+    stringstream ss(bytes);
+    BitInputStream bis(ss, 64);
+
+    // odd read sizes so refills happen at every bit offset
+    for (int i = 0; i < 400; i++) {
+        unsigned int n = 1 + rand() % 56;
+        ASSERT_EQ(cursor.readBits(n), bis.readBits(n));
+    }
+}
@@ -44,4 +44,60 @@ TEST(BitInputStreamTests, TEST_FILL) {
 
     ASSERT_EQ(bis.readBit(), 0);
     ASSERT_EQ(bis.readBit(), 1);
-}
\ No newline at end of file
+}
+TEST(BitInputStreamTests, TEST_PEEK_CONSUME) {
+    stringstream ss;
+    ss.write("\xA5\x0F", 2);
+    BitInputStream bis(ss, 4096);
+
+    ASSERT_EQ(bis.peekBits(4), 0xA);
+    ASSERT_EQ(bis.peekBits(4), 0xA);
+    bis.consumeBits(4);
+    ASSERT_EQ(bis.peekBits(8), 0x50);
+    bis.consumeBits(3);
+    ASSERT_EQ(bis.readBits(9), 0x10F);
+
+    // past the end of the input only 0s are read
+    ASSERT_EQ(bis.readBits(16), 0);
+}
+
+TEST(BitInputStreamTests, TEST_READ_BITS_MATCHES_READ_BIT) {
+    string bytes;
+    for (int i = 0; i < 300; i++) bytes += (char)(i * 37 + 11);
+
+    stringstream single(bytes);
+    stringstream multi(bytes);
+    BitInputStream bisSingle(single);
+    BitInputStream bisMulti(multi, 64);
+
+    for (unsigned int len = 0; len <= 64; len++) {
+        uint64_t expected = 0;
+        for (unsigned int i = 0; i < len; i++)
+            expected = (expected << 1) | bisSingle.readBit();
+        ASSERT_EQ(bisMulti.readBits(len), expected);
+    }
+}
+
+TEST(BitInputStreamTests, TEST_UNBUFFERED_NO_READ_AHEAD) {
+    stringstream ss;
+    ss.write("\xFFZ", 2);
+    BitInputStream bis(ss);
+
+    ASSERT_EQ(bis.readBits(8), 0xFF);
+    // the default stream only reads the bytes it needs
+    ASSERT_EQ(ss.get(), 'Z');
+}
+
+TEST(BitInputStreamTests, TEST_EXHAUSTED) {
+    stringstream ss;
+    ss.write("\xAB\xCD", 2);
+    BitInputStream bis(ss, 4096);
+
+    // the padding read into the window doesn't count until it is consumed
+    ASSERT_EQ(bis.readBits(12), 0xABC);
+    ASSERT_FALSE(bis.isExhausted());
+    ASSERT_EQ(bis.readBits(4), 0xD);
+    ASSERT_FALSE(bis.isExhausted());
+    ASSERT_EQ(bis.readBit(), 0);
+    ASSERT_TRUE(bis.isExhausted());
+}
@@ -35,4 +35,57 @@ TEST(BitOutputStreamTests, TEST_FLUSH) {
     string bitsStr = "10101111";
     unsigned int asciiVal = stoi(bitsStr, nullptr, 2);
     ASSERT_EQ(ss.get(), asciiVal);
-}
\ No newline at end of file
+}
+TEST(BitOutputStreamTests, TEST_WRITE_BITS) {
+    stringstream ss;
+    BitOutputStream bos(ss);
+    bos.writeBits(5, 3);
+    bos.writeBits(0x1F, 5);
+    bos.writeBits(1, 1);
+
+    string bitsStr = "10111111";
+    unsigned int asciiVal = stoi(bitsStr, nullptr, 2);
+    ASSERT_EQ(ss.get(), asciiVal);
+    ASSERT_EQ(bos.flush(), 7);
+    ASSERT_EQ(ss.get(), stoi("10000000", nullptr, 2));
+}
+
+TEST(BitOutputStreamTests, TEST_WRITE_BITS_MATCHES_WRITE_BIT) {
+    stringstream single;
+    stringstream multi;
+    BitOutputStream bosSingle(single);
+    BitOutputStream bosMulti(multi, 4096);
+
+    uint64_t code = 0xDEADBEEFCAFEF00DULL;
+    for (unsigned int len = 0; len <= 64; len++) {
+        for (unsigned int i = len; i > 0; i--)
+            bosSingle.writeBit((code >> (i - 1)) & 1);
+        bosMulti.writeBits(code, len);
+    }
+
+    ASSERT_EQ(bosSingle.flush(), bosMulti.flush());
+    ASSERT_EQ(single.str(), multi.str());
+}
+
+TEST(BitOutputStreamTests, TEST_BUFFERED_WRITE) {
+    stringstream ss;
+    BitOutputStream bos(ss, 4);
+    bos.writeBits(0xFFFF, 16);
+
+    // nothing is written until the byte buffer fills up or is flushed
+    ASSERT_EQ(ss.str().size(), 0);
+    ASSERT_EQ(bos.flush(), 0);
+    ASSERT_EQ(ss.str(), "\xFF\xFF");
+}
+
+TEST(BitOutputStreamTests, TEST_WRITE_COMPLETED) {
+    stringstream ss;
+    BitOutputStream bos(ss, 4096);
+    bos.writeBits(0xABCDE, 20);
+
+    // completed bytes go out now, the partial last byte stays pending
+    bos.writeCompleted();
+    ASSERT_EQ(ss.str(), "\xAB\xCD");
+    ASSERT_EQ(bos.flush(), 4);
+    ASSERT_EQ(ss.str(), "\xAB\xCD\xE0");
+}
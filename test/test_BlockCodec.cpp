@@ -0,0 +1,347 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "BlockCodec.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Encode data as one block, check the header, then decode it again */
+static void checkRoundTrip(const vector<byte>& data,
+                           const BlockOptions& options) {
+    vector<byte> block;
+    BlockCodec::encodeBlock(data.data(), data.size(), options, block);
+
+    BlockHeader header = BlockHeader::read(block.data());
+    if (header.type == STORED_BLOCK) {
+        ASSERT_EQ(header.payloadSize, header.rawSize);
+    } else if (header.type == SINGLE_BLOCK) {
+        ASSERT_EQ(count(data.begin(), data.end(), data[0]),
+                  (ptrdiff_t)data.size());
+        ASSERT_EQ(header.payloadSize, 1u);
+    } else if (header.type == RUN_BLOCK) {
+        ASSERT_LT(header.payloadSize, data.size());
+    } else if (options.order1 && header.type == ORDER1_BLOCK) {
+        ASSERT_EQ(options.numStreams, 1u);
+    } else if (options.coder == ANS_CODER ||
+               (options.coder == AUTO_CODER && header.type == ANS_BLOCK)) {
+        ASSERT_EQ(header.type, ANS_BLOCK);
+    } else {
+        ASSERT_EQ(header.type,
+                  options.numStreams > 1 ? INTERLEAVED_BLOCK : HUFFMAN_BLOCK);
+    }
+    ASSERT_EQ(header.rawSize, data.size());
+    ASSERT_EQ(header.payloadSize, block.size() - BLOCK_HEADER_SIZE);
+
+    // a coded block is always clearly smaller than the bytes it stands for
+    if (header.type != STORED_BLOCK && header.type != SINGLE_BLOCK) {
+        ASSERT_LT(header.payloadSize + header.rawSize / 32, header.rawSize);
+    }
+
+    vector<byte> decoded(header.rawSize);
+    ASSERT_TRUE(BlockCodec::decodeBlock(
+        header, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+    ASSERT_EQ(decoded, data);
+}
+
+TEST(BlockCodecTests, TEST_TEXT) {
+    string text = "every block gets its own code built from its own bytes";
+    checkRoundTrip(vector<byte>(text.begin(), text.end()), BlockOptions());
+}
+
+TEST(BlockCodecTests, TEST_ONE_SYMBOL) {
+    checkRoundTrip(vector<byte>(1000, '\n'), BlockOptions());
+    checkRoundTrip(vector<byte>(1, 'x'), BlockOptions());
+
+    // the byte is all the payload there is, whatever the block size
+    vector<byte> block;
+    vector<byte> zeros(DEFAULT_BLOCK_SIZE, 0);
+    BlockCodec::encodeBlock(zeros.data(), zeros.size(),
+                            BlockOptions(DEFAULT_BLOCK_SIZE, 0, 4), block);
+    ASSERT_EQ(BlockHeader::read(block.data()).type, SINGLE_BLOCK);
+    ASSERT_EQ(block.size(), BLOCK_HEADER_SIZE + 1);
+    checkRoundTrip(zeros, BlockOptions(DEFAULT_BLOCK_SIZE, 0, 4));
+
+    BlockHeader damaged = BlockHeader::read(block.data());
+    damaged.payloadSize = 2;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        damaged, block.data() + BLOCK_HEADER_SIZE, zeros.data()));
+}
+
+TEST(BlockCodecTests, TEST_RUNS) {
+    // mostly zeros, with short stretches of data, like a sparse file
+    srand(25);
+    vector<byte> sparse;
+    while (sparse.size() < 200000) {
+        sparse.insert(sparse.end(), 1000 + rand() % 5000, 0);
+        for (int i = rand() % 200; i > 0; i--) sparse.push_back(rand() % 256);
+    }
+    vector<byte> block;
+    BlockCodec::encodeBlock(sparse.data(), sparse.size(), BlockOptions(),
+                            block);
+    ASSERT_EQ(BlockHeader::read(block.data()).type, RUN_BLOCK);
+    ASSERT_LT(block.size(), sparse.size() / 10);
+    checkRoundTrip(sparse, BlockOptions());
+    checkRoundTrip(sparse, BlockOptions(DEFAULT_BLOCK_SIZE, 11, 1, true,
+                                        AUTO_CODER));
+
+    // runs right at the length that is coded, and long enough to need
+    // several length bytes
+    vector<byte> edges;
+    for (size_t run = 1; run < 300; run++) {
+        edges.insert(edges.end(), run % 10 + 1, 'a' + run % 3);
+        edges.insert(edges.end(), run < 290 ? 4 : 100000, '.');
+    }
+    block.clear();
+    BlockCodec::encodeBlock(edges.data(), edges.size(), BlockOptions(),
+                            block);
+    ASSERT_EQ(BlockHeader::read(block.data()).type, RUN_BLOCK);
+    checkRoundTrip(edges, BlockOptions());
+}
+
+TEST(BlockCodecTests, TEST_DAMAGED_RUNS) {
+    vector<byte> data;
+    for (int i = 0; i < 100; i++) {
+        data.insert(data.end(), 200, ' ');
+        data.insert(data.end(), 1 + i % 7, 'a' + i % 26);
+    }
+    vector<byte> block;
+    BlockCodec::encodeBlock(data.data(), data.size(), BlockOptions(), block);
+    BlockHeader header = BlockHeader::read(block.data());
+    ASSERT_EQ(header.type, RUN_BLOCK);
+
+    // runs that fall short of the block, or run past it
+    vector<byte> decoded(data.size() + 1);
+    BlockHeader longer = header;
+    longer.rawSize++;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        longer, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+    BlockHeader shorter = header;
+    shorter.rawSize--;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        shorter, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+
+    // a run coded size out of all proportion to the block
+    block[BLOCK_HEADER_SIZE + 3] = 0x7F;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        header, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+}
+
+TEST(BlockCodecTests, TEST_RANDOM_LIMITED) {
+    srand(3);
+    vector<byte> data;
+    for (int i = 0; i < 50000; i++) {
+        data.push_back(rand() % 256 & rand() % 256);
+    }
+    checkRoundTrip(data, BlockOptions(DEFAULT_BLOCK_SIZE, 11));
+    checkRoundTrip(data, BlockOptions());
+}
+
+TEST(BlockCodecTests, TEST_DECODER_ENGINES) {
+    srand(18);
+    vector<byte> data;
+    for (int i = 0; i < 20000; i++) data.push_back(rand() % (1 + i % 40));
+
+    vector<byte> block;
+    BlockCodec::encodeBlock(data.data(), data.size(), BlockOptions(), block);
+    BlockHeader header = BlockHeader::read(block.data());
+
+    DecoderEngine engines[] = {AUTO_DECODER, TABLE_DECODER, MULTI_DECODER,
+                               FSM_DECODER};
+    for (DecoderEngine engine : engines) {
+        vector<byte> decoded(header.rawSize);
+        ASSERT_TRUE(BlockCodec::decodeBlock(
+            header, block.data() + BLOCK_HEADER_SIZE, decoded.data(), engine));
+        ASSERT_EQ(decoded, data);
+    }
+}
+
+TEST(BlockCodecTests, TEST_INTERLEAVED) {
+    srand(15);
+    vector<byte> data;
+    for (int i = 0; i < 30001; i++) data.push_back(rand() % 7 * (i % 5));
+
+    for (unsigned int numStreams = 2; numStreams <= MAX_STREAMS;
+         numStreams++) {
+        checkRoundTrip(data, BlockOptions(DEFAULT_BLOCK_SIZE, 0, numStreams));
+    }
+    checkRoundTrip(data, BlockOptions(DEFAULT_BLOCK_SIZE, 9, 4));
+
+    // fewer symbols than streams
+    string text = "abc";
+    checkRoundTrip(vector<byte>(text.begin(), text.end()),
+                   BlockOptions(DEFAULT_BLOCK_SIZE, 0, 8));
+}
+
+TEST(BlockCodecTests, TEST_ORDER1) {
+    // every byte depends on the one before it, a few contexts are sparse
+    srand(5);
+    vector<byte> data(1, 'a');
+    for (int i = 0; i < 100000; i++) {
+        byte prev = data.back();
+        data.push_back(rand() % 50 == 0 ? rand() % 256
+                                         : 'a' + (prev + rand() % 3) % 26);
+    }
+    vector<byte> order0, order1;
+    BlockCodec::encodeBlock(data.data(), data.size(), BlockOptions(), order0);
+    BlockCodec::encodeBlock(data.data(), data.size(),
+                            BlockOptions(DEFAULT_BLOCK_SIZE, 0, 1, true),
+                            order1);
+    ASSERT_EQ(BlockHeader::read(order1.data()).type, ORDER1_BLOCK);
+    ASSERT_LT(order1.size(), order0.size());
+
+    checkRoundTrip(data, BlockOptions(DEFAULT_BLOCK_SIZE, 0, 1, true));
+    checkRoundTrip(data, BlockOptions(DEFAULT_BLOCK_SIZE, 11, 1, true));
+
+    // no context is worth its own code, falls back to a single code (or
+    // no code at all for one byte repeated)
+    checkRoundTrip(vector<byte>(1000, 'z'),
+                   BlockOptions(DEFAULT_BLOCK_SIZE, 0, 1, true));
+    string text = "short";
+    checkRoundTrip(vector<byte>(text.begin(), text.end()),
+                   BlockOptions(DEFAULT_BLOCK_SIZE, 0, 1, true));
+}
+
+TEST(BlockCodecTests, TEST_DAMAGED_ORDER1) {
+    srand(6);
+    vector<byte> data;
+    for (int i = 0; i < 20000; i++) data.push_back(i % 7 * 3 + rand() % 2);
+    vector<byte> block;
+    BlockCodec::encodeBlock(data.data(), data.size(),
+                            BlockOptions(DEFAULT_BLOCK_SIZE, 0, 1, true),
+                            block);
+    BlockHeader header = BlockHeader::read(block.data());
+    ASSERT_EQ(header.type, ORDER1_BLOCK);
+    vector<byte> decoded(header.rawSize);
+
+    BlockHeader truncated = header;
+    truncated.payloadSize -= 2;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        truncated, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+    truncated.payloadSize = 20;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        truncated, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+}
+
+TEST(BlockCodecTests, TEST_CODER_CHOICE) {
+    // about 0.2 bits per byte, Huffman needs at least 1
+    srand(7);
+    vector<byte> skewed;
+    for (int i = 0; i < 100000; i++) {
+        skewed.push_back(rand() % 64 == 0 ? 'a' + rand() % 4 : ' ');
+    }
+    BlockOptions autoCoder(DEFAULT_BLOCK_SIZE, 0, 1, false, AUTO_CODER);
+    vector<byte> huffman, chosen;
+    BlockCodec::encodeBlock(skewed.data(), skewed.size(), BlockOptions(),
+                            huffman);
+    BlockCodec::encodeBlock(skewed.data(), skewed.size(), autoCoder, chosen);
+    ASSERT_EQ(BlockHeader::read(chosen.data()).type, ANS_BLOCK);
+    // the spaces come in runs, so even Huffman only codes the run lengths
+    ASSERT_EQ(BlockHeader::read(huffman.data()).type, RUN_BLOCK);
+    ASSERT_LT(chosen.size(), huffman.size() / 3 * 2);
+    checkRoundTrip(skewed, autoCoder);
+
+    // 16 equally likely bytes take 4 bits each, Huffman can't do better
+    vector<byte> even;
+    for (int i = 0; i < 100000; i++) even.push_back('a' + rand() % 16);
+    chosen.clear();
+    BlockCodec::encodeBlock(even.data(), even.size(), autoCoder, chosen);
+    ASSERT_EQ(BlockHeader::read(chosen.data()).type, HUFFMAN_BLOCK);
+
+    // close to uniform bytes don't shrink at all, they are stored
+    vector<byte> flat;
+    for (int i = 0; i < 100000; i++) flat.push_back(rand() % 256);
+    chosen.clear();
+    BlockCodec::encodeBlock(flat.data(), flat.size(), autoCoder, chosen);
+    ASSERT_EQ(BlockHeader::read(chosen.data()).type, STORED_BLOCK);
+
+    BlockOptions ansCoder(DEFAULT_BLOCK_SIZE, 0, 1, false, ANS_CODER);
+    checkRoundTrip(flat, ansCoder);
+    checkRoundTrip(vector<byte>(1000, '\n'), ansCoder);
+    checkRoundTrip(vector<byte>(1, 'x'), ansCoder);
+}
+
+TEST(BlockCodecTests, TEST_STORED) {
+    // random bytes don't shrink, they are copied as they are
+    srand(8);
+    vector<byte> random;
+    for (int i = 0; i < 100000; i++) random.push_back(rand() % 256);
+    BlockOptions options[] = {
+        BlockOptions(), BlockOptions(DEFAULT_BLOCK_SIZE, 0, 8),
+        BlockOptions(DEFAULT_BLOCK_SIZE, 0, 1, true, AUTO_CODER)};
+    for (const BlockOptions& option : options) {
+        vector<byte> block;
+        BlockCodec::encodeBlock(random.data(), random.size(), option, block);
+        BlockHeader header = BlockHeader::read(block.data());
+        ASSERT_EQ(header.type, STORED_BLOCK);
+        ASSERT_EQ(BlockCodec::storedData(header,
+                                         block.data() + BLOCK_HEADER_SIZE),
+                  block.data() + BLOCK_HEADER_SIZE);
+        checkRoundTrip(random, option);
+    }
+
+    // so is a block too short for its code table to pay off
+    vector<byte> block;
+    string text = "tiny";
+    BlockCodec::encodeBlock((const byte*)text.data(), text.size(),
+                            BlockOptions(), block);
+    ASSERT_EQ(BlockHeader::read(block.data()).type, STORED_BLOCK);
+    ASSERT_EQ(block.size(), BLOCK_HEADER_SIZE + text.size());
+
+    // a stored block with the wrong payload size is damaged
+    BlockHeader header = BlockHeader::read(block.data());
+    header.payloadSize--;
+    vector<byte> decoded(header.rawSize);
+    ASSERT_EQ(BlockCodec::storedData(header, block.data() + BLOCK_HEADER_SIZE),
+              nullptr);
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        header, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+}
+
+TEST(BlockCodecTests, TEST_DAMAGED_INTERLEAVED) {
+    // long enough not to be stored
+    string text;
+    for (int i = 0; i < 20; i++) {
+        text += "stream sizes have to add up to the payload size ";
+    }
+    vector<byte> block;
+    BlockCodec::encodeBlock((const byte*)text.data(), text.size(),
+                            BlockOptions(DEFAULT_BLOCK_SIZE, 0, 4), block);
+    BlockHeader header = BlockHeader::read(block.data());
+    vector<byte> decoded(header.rawSize);
+
+    BlockHeader truncated = header;
+    truncated.payloadSize -= 1;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        truncated, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+}
+
+TEST(BlockCodecTests, TEST_DAMAGED_BLOCK) {
+    // long enough not to be stored
+    string text;
+    for (int i = 0; i < 20; i++) {
+        text += "damaged blocks are reported instead of decoded ";
+    }
+    vector<byte> block;
+    BlockCodec::encodeBlock((const byte*)text.data(), text.size(),
+                            BlockOptions(), block);
+    BlockHeader header = BlockHeader::read(block.data());
+    vector<byte> decoded(header.rawSize);
+
+    // payload cut short before the end of the bit stream
+    BlockHeader truncated = header;
+    truncated.payloadSize -= 2;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        truncated, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+
+    // unknown block type
+    BlockHeader unknown = header;
+    unknown.type = 200;
+    ASSERT_FALSE(BlockCodec::decodeBlock(
+        unknown, block.data() + BLOCK_HEADER_SIZE, decoded.data()));
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BlockCompressor.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Compress data with numThreads threads and return the container */
+static string compress(const vector<byte>& data, unsigned int numThreads) {
+    stringstream ss;
+    BlockCompressor compressor(ss, BlockOptions(MIN_BLOCK_SIZE), numThreads);
+    compressor.addData(data.data(), data.size());
+    compressor.finish();
+    return ss.str();
+}
+
+/* Decode every block of a container back into one buffer */
+static vector<byte> decompress(const string& container) {
+    const byte* p = (const byte*)container.data() + BLOCK_MAGIC_SIZE;
+    vector<byte> decoded;
+    while (1) {
+        BlockHeader header = BlockHeader::read(p);
+        if (header.type == END_BLOCK) break;
+        size_t start = decoded.size();
+        decoded.resize(start + header.rawSize);
+        EXPECT_TRUE(BlockCodec::decodeBlock(header, p + BLOCK_HEADER_SIZE,
+                                            decoded.data() + start));
+        p += BLOCK_HEADER_SIZE + header.payloadSize;
+    }
+    return decoded;
+}
+
+class BlockCompressorFixture : public ::testing::Test {
+  protected:
+    vector<byte> data;
+
+  public:
+    BlockCompressorFixture() {
+        // blocks with different byte distributions
+        srand(12);
+        for (int i = 0; i < 100000; i++) {
+            int range = 4 + (i / MIN_BLOCK_SIZE) * 9 % 250;
+            data.push_back(rand() % range);
+        }
+    }
+};
+
+TEST_F(BlockCompressorFixture, TEST_THREADS_MATCH_ONE_THREAD) {
+    string single = compress(data, 1);
+    ASSERT_EQ(single.substr(0, BLOCK_MAGIC_SIZE), string(BLOCK_MAGIC, BLOCK_MAGIC_SIZE));
+    ASSERT_EQ(decompress(single), data);
+
+    for (unsigned int numThreads = 2; numThreads <= 8; numThreads *= 2) {
+        ASSERT_EQ(compress(data, numThreads), single);
+    }
+}
+
+TEST_F(BlockCompressorFixture, TEST_ADD_BLOCK) {
+    stringstream ss;
+    BlockCompressor compressor(ss, BlockOptions(MIN_BLOCK_SIZE), 4);
+    for (size_t start = 0; start < data.size(); start += MIN_BLOCK_SIZE) {
+        size_t end = min(data.size(), start + MIN_BLOCK_SIZE);
+        compressor.addBlock(
+            vector<byte>(data.begin() + start, data.begin() + end));
+    }
+    compressor.finish();
+    ASSERT_EQ(ss.str(), compress(data, 1));
+}
+
+TEST(BlockCompressorTests, TEST_EMPTY) {
+    string container = compress(vector<byte>(), 3);
+    ASSERT_EQ(container.size(),
+              BLOCK_MAGIC_SIZE + BLOCK_HEADER_SIZE + INDEX_TRAILER_SIZE);
+    ASSERT_TRUE(decompress(container).empty());
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "BlockCompressor.hpp"
+#include "BlockDecompressor.hpp"
+
+using namespace std;
+using namespace testing;
+
+class BlockDecompressorFixture : public ::testing::Test {
+  protected:
+    vector<byte> data;
+    string container;
+
+  public:
+    BlockDecompressorFixture() {
+        srand(13);
+        for (int i = 0; i < 70000; i++) {
+            data.push_back(rand() % (2 + i / MIN_BLOCK_SIZE));
+        }
+
+        stringstream ss;
+        BlockCompressor compressor(ss, BlockOptions(MIN_BLOCK_SIZE), 1);
+        compressor.addData(data.data(), data.size());
+        compressor.finish();
+        container = ss.str();
+    }
+
+    const byte* bytes() const { return (const byte*)container.data(); }
+};
+
+TEST_F(BlockDecompressorFixture, TEST_READ_INDEX) {
+    vector<BlockIndexEntry> index;
+    ASSERT_TRUE(
+        BlockDecompressor::readIndex(bytes(), container.size(), index));
+    ASSERT_EQ(index.size(), (data.size() + MIN_BLOCK_SIZE - 1) / MIN_BLOCK_SIZE);
+    ASSERT_EQ(BlockDecompressor::rawSize(index), data.size());
+    ASSERT_EQ(index[0].offset, BLOCK_MAGIC_SIZE);
+    for (size_t i = 0; i < index.size(); i++) {
+        ASSERT_EQ(index[i].rawOffset, i * MIN_BLOCK_SIZE);
+    }
+}
+
+TEST_F(BlockDecompressorFixture, TEST_BAD_INDEX) {
+    vector<BlockIndexEntry> index;
+
+    // no trailer
+    string cut = container.substr(0, container.size() - 1);
+    ASSERT_FALSE(BlockDecompressor::readIndex((const byte*)cut.data(),
+                                              cut.size(), index));
+
+    // entry pointing into the middle of a block
+    size_t indexOffset = getInt(bytes() + container.size() - 12 - 4, 8);
+    string moved = container;
+    moved[indexOffset + INDEX_ENTRY_SIZE]++;
+    ASSERT_FALSE(BlockDecompressor::readIndex((const byte*)moved.data(),
+                                              moved.size(), index));
+    ASSERT_TRUE(index.empty());
+}
+
+TEST_F(BlockDecompressorFixture, TEST_DECODE_TO_FILE) {
+    vector<BlockIndexEntry> index;
+    ASSERT_TRUE(
+        BlockDecompressor::readIndex(bytes(), container.size(), index));
+
+    for (unsigned int numThreads = 1; numThreads <= 4; numThreads++) {
+        FILE* file = tmpfile();
+        int fd = fileno(file);
+        ASSERT_EQ(ftruncate(fd, BlockDecompressor::rawSize(index)), 0);
+        ASSERT_TRUE(
+            BlockDecompressor::decodeToFile(bytes(), index, fd, numThreads)
+                .empty());
+
+        vector<byte> decoded(data.size());
+        ASSERT_EQ(pread(fd, decoded.data(), decoded.size(), 0),
+                  (ssize_t)decoded.size());
+        ASSERT_EQ(decoded, data);
+        fclose(file);
+    }
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HCAdaptiveTree.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Input that arrives in pieces, like a pipe from a slow producer. Nothing
+ * is ready once a piece is used up, and when the next piece is asked for,
+ * the size of a watched stream is noted */
+class TrickleBuf : public streambuf {
+  private:
+    vector<string> pieces;  // the input, piece by piece
+    size_t next;            // index of the next piece to hand out
+    const stringstream& watched;  // output stream to look at
+
+  public:
+    vector<size_t> seen;  // size of watched when each later piece was read
+
+    TrickleBuf(const vector<string>& pieces, const stringstream& watched)
+        : pieces(pieces), next(0), watched(watched) {}
+
+  protected:
+    int_type underflow() override {
+        if (next == pieces.size()) return traits_type::eof();
+        if (next > 0) seen.push_back(watched.str().size());
+        string& piece = pieces[next++];
+        setg(&piece[0], &piece[0], &piece[0] + piece.size());
+        return traits_type::to_int_type(piece[0]);
+    }
+
+    // the next piece isn't there until it is waited for
+    streamsize showmanyc() override { return 0; }
+};
+
+/* Encode input with one adaptive tree and decode it with another. Returns
+ * the number of bytes the encoded data took */
+static size_t checkRoundTrip(const vector<byte>& input) {
+    stringstream ss;
+    HCAdaptiveTree encoder;
+    BitOutputStream bos(ss, 4096);
+    for (byte c : input) encoder.encode(c, bos);
+    encoder.encode(HCAdaptiveTree::END_SYMBOL, bos);
+    bos.flush();
+    size_t size = ss.str().size();
+
+    HCAdaptiveTree decoder;
+    BitInputStream bis(ss, 4096);
+    vector<byte> decoded;
+    while (1) {
+        unsigned int symbol = decoder.decode(bis);
+        if (symbol == HCAdaptiveTree::END_SYMBOL) break;
+        decoded.push_back(symbol);
+    }
+    EXPECT_EQ(decoded, input);
+    return size;
+}
+
+TEST(HCAdaptiveTreeTests, TEST_EMPTY) {
+    // just the end symbol, 9 bits
+    ASSERT_EQ(checkRoundTrip(vector<byte>()), 2);
+}
+
+TEST(HCAdaptiveTreeTests, TEST_TEXT) {
+    string text = "abracadabra, the code follows the data as it goes";
+    checkRoundTrip(vector<byte>(text.begin(), text.end()));
+}
+
+TEST(HCAdaptiveTreeTests, TEST_ONE_SYMBOL) {
+    // after the first one, every byte costs a single bit
+    size_t size = checkRoundTrip(vector<byte>(8000, 'x'));
+    ASSERT_LE(size, 1010);
+}
+
+TEST(HCAdaptiveTreeTests, TEST_ALL_SYMBOLS) {
+    srand(19);
+    vector<byte> input;
+    for (int i = 0; i < 256; i++) input.push_back(i);
+    for (int i = 0; i < 50000; i++) {
+        input.push_back(rand() % 256 & rand() % 256 & rand() % 256);
+    }
+    checkRoundTrip(input);
+}
+
+TEST(HCAdaptiveTreeTests, TEST_CHANGING_DISTRIBUTION) {
+    srand(20);
+    vector<byte> input;
+    for (int part = 0; part < 8; part++) {
+        for (int i = 0; i < 5000; i++) input.push_back(part * 16 + rand() % 4);
+    }
+    checkRoundTrip(input);
+}
+
+TEST(HCAdaptiveTreeTests, TEST_STREAMING) {
+    vector<string> lines = {"the first line comes in\n",
+                            "the second line a while later\n",
+                            "and the last one after that\n"};
+    string text = lines[0] + lines[1] + lines[2];
+
+    // every line is coded and sent before the next one is waited for
+    stringstream coded;
+    TrickleBuf lineBuf(lines, coded);
+    istream lineStream(&lineBuf);
+    HCAdaptiveTree::encodeStream(lineStream, coded);
+    ASSERT_EQ(lineBuf.seen.size(), 2u);
+    ASSERT_GE(lineBuf.seen[0], lines[0].size() / 2);
+    ASSERT_GT(lineBuf.seen[1], lineBuf.seen[0]);
+
+    // and decoding gets as far as the coded bytes that have arrived
+    string all = coded.str();
+    size_t half = all.size() / 2;
+    stringstream decoded;
+    TrickleBuf codedBuf({all.substr(0, half), all.substr(half)}, decoded);
+    istream codedStream(&codedBuf);
+    ASSERT_TRUE(HCAdaptiveTree::decodeStream(codedStream, decoded));
+    ASSERT_EQ(decoded.str(), text);
+    ASSERT_EQ(codedBuf.seen.size(), 1u);
+    ASSERT_GE(codedBuf.seen[0], lines[0].size());
+}
+
+TEST(HCAdaptiveTreeTests, TEST_TRUNCATED_STREAM) {
+    string text = "a stream cut short ends with an error, not garbage";
+    stringstream in(text), coded;
+    HCAdaptiveTree::encodeStream(in, coded);
+
+    string all = coded.str();
+    stringstream truncated(all.substr(0, all.size() / 2)), decoded;
+    ASSERT_FALSE(HCAdaptiveTree::decodeStream(truncated, decoded));
+    ASSERT_LT(decoded.str().size(), text.size());
+    ASSERT_EQ(decoded.str(), text.substr(0, decoded.str().size()));
+}
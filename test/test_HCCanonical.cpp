@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "HCCanonical.hpp"
+#include "HCDecodeTable.hpp"
+#include "HCTree.hpp"
+
+using namespace std;
+using namespace testing;
+
+TEST(HCCanonicalTests, TEST_CODES_FROM_LENGTHS) {
+    // example code from the DEFLATE spec (RFC 1951)
+    vector<unsigned int> lengths(256);
+    string symbols = "ABCDEFGH";
+    unsigned int symbolLengths[] = {3, 3, 3, 3, 3, 2, 4, 4};
+    for (int i = 0; i < 8; i++) lengths[symbols[i]] = symbolLengths[i];
+
+    vector<HCCode> codes = HCCanonical::codesFromLengths(lengths);
+    ASSERT_EQ(codes['F'].bits, 0);
+    ASSERT_EQ(codes['A'].bits, 2);
+    ASSERT_EQ(codes['E'].bits, 6);
+    ASSERT_EQ(codes['G'].bits, 14);
+    ASSERT_EQ(codes['H'].bits, 15);
+    ASSERT_EQ(codes['H'].length, 4);
+    ASSERT_EQ(codes['Z'].length, 0);
+}
+
+TEST(HCCanonicalTests, TEST_SPARSE_HEADER) {
+    vector<unsigned int> lengths(256);
+    lengths['a'] = 1;
+    lengths['b'] = 2;
+    lengths['c'] = 2;
+
+    stringstream ss;
+    HCCanonical::writeLengths(ss, lengths);
+    ASSERT_EQ(ss.str().size(), 8);
+    ASSERT_EQ(HCCanonical::lengthsSize(lengths), 8);
+
+    vector<unsigned int> readBack;
+    ASSERT_TRUE(HCCanonical::readLengths(ss, readBack));
+    ASSERT_EQ(readBack, lengths);
+}
+
+TEST(HCCanonicalTests, TEST_NIBBLE_HEADER) {
+    vector<unsigned int> freqs(256);
+    for (int i = 0; i < 256; i++) freqs[i] = 1 + (i * 31) % 97;
+    HCTree tree;
+    tree.build(freqs);
+    vector<unsigned int> lengths = HCCanonical::codeLengths(tree.getCodes());
+
+    stringstream ss;
+    HCCanonical::writeLengths(ss, lengths);
+    ASSERT_EQ(ss.str().size(), 129);
+    ASSERT_EQ(HCCanonical::lengthsSize(lengths), 129);
+
+    vector<unsigned int> readBack;
+    ASSERT_TRUE(HCCanonical::readLengths(ss, readBack));
+    ASSERT_EQ(readBack, lengths);
+}
+
+TEST(HCCanonicalTests, TEST_BAD_HEADER) {
+    vector<unsigned int> lengths;
+    stringstream truncated(string("\x00\x02\x41\x01", 4));
+    ASSERT_FALSE(HCCanonical::readLengths(truncated, lengths));
+
+    // three codewords of length 1 can't exist
+    stringstream oversubscribed(string("\x00\x02\x41\x01\x42\x01\x43\x01", 8));
+    ASSERT_FALSE(HCCanonical::readLengths(oversubscribed, lengths));
+
+    // lengths 1, 1 and 57 are over the code space by less than a double
+    // can tell from 1
+    stringstream barelyOver(string("\x00\x02\x41\x01\x42\x01\x43\x39", 8));
+    ASSERT_FALSE(HCCanonical::readLengths(barelyOver, lengths));
+
+    // lengths 1 to 56 and two of 57 fill the code space exactly
+    vector<unsigned int> full(256, 0);
+    for (unsigned int len = 1; len <= HCCanonical::MAX_LENGTH; len++) {
+        full[len] = len;
+    }
+    full[HCCanonical::MAX_LENGTH + 1] = HCCanonical::MAX_LENGTH;
+    stringstream fullHeader;
+    HCCanonical::writeLengths(fullHeader, full);
+    ASSERT_TRUE(HCCanonical::readLengths(fullHeader, lengths));
+    ASSERT_EQ(lengths, full);
+}
+
+TEST(HCCanonicalTests, TEST_ROUND_TRIP) {
+    vector<unsigned int> freqs(256);
+    string input = "canonical huffman codes only need their lengths";
+    for (char c : input) freqs[(byte)c]++;
+    HCTree tree;
+    tree.build(freqs);
+    vector<HCCode> codes = HCCanonical::codesFromLengths(
+        HCCanonical::codeLengths(tree.getCodes()));
+
+    stringstream ss;
+    BitOutputStream bos(ss);
+    for (char c : input) {
+        bos.writeBits(codes[(byte)c].bits, codes[(byte)c].length);
+    }
+    bos.flush();
+
+    HCDecodeTable table(codes);
+    BitInputStream bis(ss);
+    for (char c : input) ASSERT_EQ(table.decode(bis), (byte)c);
+}
+
+/* Fibonacci counts, the worst case for codeword length */
+static vector<unsigned int> fibonacciFreqs(int numSymbols) {
+    vector<unsigned int> freqs(256);
+    unsigned int a = 1, b = 1;
+    for (int i = 0; i < numSymbols; i++) {
+        freqs[i] = a;
+        unsigned int next = a + b;
+        a = b;
+        b = next;
+    }
+    return freqs;
+}
+
+/* Total encoded bits of the data for the given code lengths */
+static uint64_t encodedBits(const vector<unsigned int>& freqs,
+                            const vector<unsigned int>& lengths) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 256; i++) bits += (uint64_t)freqs[i] * lengths[i];
+    return bits;
+}
+
+TEST(HCCanonicalTests, TEST_LIMITED_LENGTHS) {
+    vector<unsigned int> freqs = fibonacciFreqs(40);
+    HCTree unlimited;
+    unlimited.build(freqs);
+    vector<unsigned int> huffman =
+        HCCanonical::codeLengths(unlimited.getCodes());
+    ASSERT_EQ(*max_element(huffman.begin(), huffman.end()), 39);
+
+    unsigned int limits[] = {11, 12, 15};
+    for (unsigned int limit : limits) {
+        vector<unsigned int> lengths =
+            HCCanonical::limitedLengths(freqs, limit);
+        ASSERT_EQ(*max_element(lengths.begin(), lengths.end()), limit);
+
+        // the limited code must be complete
+        double kraft = 0;
+        for (int i = 0; i < 256; i++) {
+            ASSERT_EQ(lengths[i] != 0, freqs[i] != 0);
+            if (lengths[i] != 0) kraft += 1.0 / (1 << lengths[i]);
+        }
+        ASSERT_DOUBLE_EQ(kraft, 1.0);
+        ASSERT_GT(encodedBits(freqs, lengths), encodedBits(freqs, huffman));
+    }
+}
+
+TEST(HCCanonicalTests, TEST_LIMIT_ABOVE_DEPTH_IS_HUFFMAN) {
+    vector<unsigned int> freqs(256);
+    for (int i = 0; i < 256; i++) freqs[i] = 1 + (i * 7919) % 1000;
+    HCTree tree;
+    tree.build(freqs);
+    vector<unsigned int> huffman = HCCanonical::codeLengths(tree.getCodes());
+
+    vector<unsigned int> lengths = HCCanonical::limitedLengths(freqs, 30);
+    ASSERT_EQ(encodedBits(freqs, lengths), encodedBits(freqs, huffman));
+
+    // 256 symbols need at least 8 bits, so a lower limit is raised
+    lengths = HCCanonical::limitedLengths(freqs, 4);
+    ASSERT_EQ(*max_element(lengths.begin(), lengths.end()), 8);
+}
+
+TEST(HCCanonicalTests, TEST_BUILD_WITH_MAX_CODE_LENGTH) {
+    vector<unsigned int> freqs = fibonacciFreqs(40);
+    HCTree tree;
+    tree.build(freqs, 12);
+
+    const vector<HCCode>& codes = tree.getCodes();
+    for (int i = 0; i < 256; i++) ASSERT_LE(codes[i].length, 12);
+
+    // the rebuilt tree decodes what its code table encodes
+    stringstream ss;
+    BitOutputStream bos(ss);
+    for (int i = 0; i < 40; i++) tree.encode(i, bos);
+    bos.flush();
+
+    HCDecodeTable table(codes);
+    stringstream copy(ss.str());
+    BitInputStream bis(ss);
+    BitInputStream bisTable(copy);
+    for (int i = 0; i < 40; i++) {
+        ASSERT_EQ(tree.decode(bis), i);
+        ASSERT_EQ(table.decode(bisTable), i);
+    }
+}
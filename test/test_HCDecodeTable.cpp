@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "HCDecodeTable.hpp"
+#include "HCTree.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Encode random symbols drawn from freqs, then check the lookup table decodes
+ * the same symbols as walking the tree */
+static void checkMatchesTreeDecode(const vector<unsigned int>& freqs,
+                                   unsigned int tableBits) {
+    HCTree tree;
+    tree.build(freqs);
+    HCDecodeTable table(tree.getCodes(), tableBits);
+
+    vector<byte> symbols;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] != 0) symbols.push_back(i);
+    }
+
+    srand(100);
+    vector<byte> input;
+    for (int i = 0; i < 5000; i++) {
+        input.push_back(symbols[rand() % symbols.size()]);
+    }
+
+    stringstream ss;
+    BitOutputStream bos(ss, 4096);
+    for (byte c : input) tree.encode(c, bos);
+    bos.flush();
+
+    stringstream treeIn(ss.str());
+    stringstream tableIn(ss.str());
+    BitInputStream bisTree(treeIn);
+    BitInputStream bisTable(tableIn, 4096);
+    for (byte c : input) {
+        ASSERT_EQ(tree.decode(bisTree), c);
+        ASSERT_EQ(table.decode(bisTable), c);
+    }
+}
+
+TEST(HCDecodeTableTests, TEST_SIMPLE) {
+    vector<unsigned int> freqs(256);
+    freqs['A'] = 1;
+    freqs['B'] = 2;
+    freqs['C'] = 2;
+    freqs['D'] = 3;
+    freqs['E'] = 4;
+    checkMatchesTreeDecode(freqs, HCDecodeTable::DEFAULT_TABLE_BITS);
+}
+
+TEST(HCDecodeTableTests, TEST_ONE_SYMBOL) {
+    vector<unsigned int> freqs(256);
+    freqs['A'] = 5;
+    checkMatchesTreeDecode(freqs, HCDecodeTable::DEFAULT_TABLE_BITS);
+}
+
+TEST(HCDecodeTableTests, TEST_ALL_SYMBOLS) {
+    vector<unsigned int> freqs(256);
+    for (int i = 0; i < 256; i++) freqs[i] = 1 + (i * 7919) % 1000;
+    checkMatchesTreeDecode(freqs, HCDecodeTable::DEFAULT_TABLE_BITS);
+}
+
+TEST(HCDecodeTableTests, TEST_LONG_CODES_MULTI_LEVEL) {
+    // fibonacci counts give codewords up to 29 bits, which need several
+    // levels of 4 and 11 bit tables
+    vector<unsigned int> freqs(256);
+    unsigned int a = 1, b = 1;
+    for (int i = 0; i < 30; i++) {
+        freqs['a' + i] = a;
+        unsigned int next = a + b;
+        a = b;
+        b = next;
+    }
+    checkMatchesTreeDecode(freqs, 4);
+    checkMatchesTreeDecode(freqs, HCDecodeTable::DEFAULT_TABLE_BITS);
+}
+
+/* Encode random symbols round-robin into 8 streams with a length-limited
+ * tree, then check the interleaved decoder (AVX2 where the CPU has it)
+ * against walking the tree through each stream */
+static void checkInterleavedMatchesTreeDecode(unsigned int numSymbols,
+                                              size_t n, unsigned int seed) {
+    srand(seed);
+    vector<unsigned int> freqs(256);
+    for (unsigned int i = 0; i < numSymbols; i++) {
+        freqs[rand() % 256] += 1 + rand() % (1 << (rand() % 16));
+    }
+    vector<byte> symbols;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] != 0) symbols.push_back(i);
+    }
+
+    HCTree tree;
+    tree.build(freqs, HCDecodeTable::DEFAULT_TABLE_BITS);
+    HCDecodeTable table(tree.getCodes());
+    ASSERT_TRUE(table.hasFlatTable());
+
+    vector<byte> input;
+    for (size_t i = 0; i < n; i++) {
+        input.push_back(symbols[rand() % symbols.size()]);
+    }
+
+    const unsigned int numStreams = HCDecodeTable::AVX2_LANES;
+    vector<string> streams(numStreams);
+    string data;
+    vector<size_t> offsets, sizes;
+    for (unsigned int s = 0; s < numStreams; s++) {
+        stringstream ss;
+        BitOutputStream bos(ss, 4096);
+        for (size_t i = s; i < n; i += numStreams) tree.encode(input[i], bos);
+        bos.flush();
+        streams[s] = ss.str();
+        offsets.push_back(data.size());
+        sizes.push_back(streams[s].size());
+        data += streams[s];
+    }
+
+    vector<byte> decoded(n);
+    table.decode((const byte*)data.data(), offsets.data(), sizes.data(),
+                 numStreams, decoded.data(), n);
+
+    for (unsigned int s = 0; s < numStreams; s++) {
+        stringstream treeIn(streams[s]);
+        BitInputStream bis(treeIn);
+        for (size_t i = s; i < n; i += numStreams) {
+            ASSERT_EQ(decoded[i], tree.decode(bis));
+            ASSERT_EQ(decoded[i], input[i]);
+        }
+    }
+}
+
+TEST(HCDecodeTableTests, TEST_INTERLEAVED_MATCHES_TREE_DECODE) {
+    for (unsigned int seed = 0; seed < 20; seed++) {
+        checkInterleavedMatchesTreeDecode(1 + seed * 13, 1000 + seed * 997,
+                                          seed);
+    }
+
+    // too few symbols for the kernel to run at all
+    checkInterleavedMatchesTreeDecode(40, 30, 99);
+}
+
+TEST(HCDecodeTableTests, TEST_AVX2_KERNEL) {
+    if (!HCDecodeTable::hasAVX2()) return;
+
+    vector<unsigned int> freqs(256);
+    for (int i = 0; i < 256; i++) freqs[i] = 1 + (i * 7919) % 1000;
+    HCTree tree;
+    tree.build(freqs, HCDecodeTable::DEFAULT_TABLE_BITS);
+    HCDecodeTable table(tree.getCodes());
+
+    // the same stream 8 times, every lane decodes the same symbols
+    srand(16);
+    vector<byte> input;
+    for (int i = 0; i < 4000; i++) input.push_back(rand() % 256);
+    stringstream ss;
+    BitOutputStream bos(ss, 4096);
+    for (byte c : input) tree.encode(c, bos);
+    bos.flush();
+    string stream = ss.str();
+
+    string data;
+    vector<size_t> offsets, sizes;
+    for (unsigned int l = 0; l < HCDecodeTable::AVX2_LANES; l++) {
+        offsets.push_back(data.size());
+        sizes.push_back(stream.size());
+        data += stream;
+    }
+
+    vector<uint32_t> bitPos(HCDecodeTable::AVX2_LANES, 0);
+    vector<byte> decoded(HCDecodeTable::AVX2_LANES * input.size());
+    size_t rounds =
+        table.decodeAVX2((const byte*)data.data(), offsets.data(),
+                         sizes.data(), bitPos.data(), decoded.data(),
+                         input.size());
+
+    // only the last few symbols are left to the scalar decoder
+    ASSERT_GT(rounds, input.size() * 9 / 10);
+    for (size_t r = 0; r < rounds; r++) {
+        for (unsigned int l = 0; l < HCDecodeTable::AVX2_LANES; l++) {
+            ASSERT_EQ(decoded[r * HCDecodeTable::AVX2_LANES + l], input[r]);
+        }
+    }
+    for (unsigned int l = 1; l < HCDecodeTable::AVX2_LANES; l++) {
+        ASSERT_EQ(bitPos[l], bitPos[0]);
+    }
+}
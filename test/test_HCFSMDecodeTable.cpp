@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HCFSMDecodeTable.hpp"
+#include "HCTree.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Encode random symbols drawn from freqs and check the state machine
+ * decodes them back */
+static void checkRoundTrip(const vector<unsigned int>& freqs, size_t n) {
+    HCTree tree;
+    tree.build(freqs);
+    HCFSMDecodeTable fsm(tree.getCodes());
+    ASSERT_TRUE(fsm.isValid());
+
+    vector<byte> symbols;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] != 0) symbols.push_back(i);
+    }
+
+    srand(18);
+    vector<byte> input;
+    for (size_t i = 0; i < n; i++) {
+        input.push_back(symbols[rand() % symbols.size()]);
+    }
+
+    stringstream ss;
+    BitOutputStream bos(ss, 4096);
+    for (byte c : input) tree.encode(c, bos);
+    bos.flush();
+    string stream = ss.str();
+
+    vector<byte> decoded(n);
+    fsm.decode((const byte*)stream.data(), stream.size(), decoded.data(), n);
+    ASSERT_EQ(decoded, input);
+}
+
+TEST(HCFSMDecodeTableTests, TEST_SIMPLE) {
+    vector<unsigned int> freqs(256);
+    freqs['A'] = 1;
+    freqs['B'] = 2;
+    freqs['C'] = 2;
+    freqs['D'] = 3;
+    freqs['E'] = 4;
+    checkRoundTrip(freqs, 5000);
+    checkRoundTrip(freqs, 3);
+}
+
+TEST(HCFSMDecodeTableTests, TEST_ONE_SYMBOL) {
+    // one codeword of one bit, every byte finishes 8 symbols
+    vector<unsigned int> freqs(256);
+    freqs['A'] = 5;
+    checkRoundTrip(freqs, 1001);
+}
+
+TEST(HCFSMDecodeTableTests, TEST_ALL_SYMBOLS_LONG_CODES) {
+    // codewords longer than a byte carry their state across bytes
+    vector<unsigned int> freqs(256);
+    unsigned int a = 1, b = 1;
+    for (int i = 0; i < 256; i++) {
+        freqs[i] = i < 30 ? a : 1;
+        unsigned int next = a + b;
+        a = b;
+        b = next;
+    }
+    checkRoundTrip(freqs, 5000);
+}
+
+TEST(HCFSMDecodeTableTests, TEST_TOO_MANY_STATES) {
+    // an incomplete code where every codeword has its own chain of
+    // internal nodes, far more than MAX_STATES of them
+    vector<HCCode> codes(256);
+    for (int i = 0; i < 200; i++) codes[i] = {uint64_t(i) << 30, 38};
+    HCFSMDecodeTable fsm(codes);
+    ASSERT_FALSE(fsm.isValid());
+
+    byte data[1] = {0};
+    byte out[4] = {1, 1, 1, 1};
+    fsm.decode(data, 1, out, 4);
+    ASSERT_EQ(out[3], 0);
+}
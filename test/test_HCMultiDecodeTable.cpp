@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "HCMultiDecodeTable.hpp"
+#include "HCTree.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Encode random symbols drawn from freqs, decode them with the multi-symbol
+ * table in two calls, and check they match the input */
+static void checkRoundTrip(const vector<unsigned int>& freqs,
+                           unsigned int tableBits) {
+    HCTree tree;
+    tree.build(freqs);
+    HCMultiDecodeTable table(tree.getCodes(), tableBits);
+
+    vector<byte> symbols;
+    for (int i = 0; i < 256; i++) {
+        if (freqs[i] != 0) symbols.push_back(i);
+    }
+
+    srand(17);
+    vector<byte> input;
+    for (int i = 0; i < 5000; i++) {
+        input.push_back(symbols[rand() % symbols.size()]);
+    }
+
+    stringstream ss;
+    BitOutputStream bos(ss, 4096);
+    for (byte c : input) tree.encode(c, bos);
+    bos.flush();
+
+    // the split must not lose or skip any bits
+    BitInputStream bis(ss, 4096);
+    vector<byte> decoded(input.size());
+    table.decode(bis, decoded.data(), 1001);
+    table.decode(bis, decoded.data() + 1001, input.size() - 1001);
+    ASSERT_EQ(decoded, input);
+}
+
+TEST(HCMultiDecodeTableTests, TEST_SHORT_CODES) {
+    vector<unsigned int> freqs(256);
+    freqs['A'] = 10;
+    freqs['B'] = 5;
+    freqs['C'] = 3;
+    freqs['D'] = 1;
+    checkRoundTrip(freqs, HCMultiDecodeTable::DEFAULT_TABLE_BITS);
+    checkRoundTrip(freqs, 3);
+}
+
+TEST(HCMultiDecodeTableTests, TEST_ONE_SYMBOL) {
+    vector<unsigned int> freqs(256);
+    freqs['A'] = 5;
+    checkRoundTrip(freqs, HCMultiDecodeTable::DEFAULT_TABLE_BITS);
+}
+
+TEST(HCMultiDecodeTableTests, TEST_ALL_SYMBOLS) {
+    vector<unsigned int> freqs(256);
+    for (int i = 0; i < 256; i++) freqs[i] = 1 + (i * 7919) % 1000;
+    checkRoundTrip(freqs, HCMultiDecodeTable::DEFAULT_TABLE_BITS);
+}
+
+TEST(HCMultiDecodeTableTests, TEST_LONG_CODES_FALL_BACK) {
+    // fibonacci counts give codewords up to 29 bits, longer than the table
+    vector<unsigned int> freqs(256);
+    unsigned int a = 1, b = 1;
+    for (int i = 0; i < 30; i++) {
+        freqs['a' + i] = a;
+        unsigned int next = a + b;
+        a = b;
+        b = next;
+    }
+    checkRoundTrip(freqs, HCMultiDecodeTable::DEFAULT_TABLE_BITS);
+}
+
+TEST(HCMultiDecodeTableTests, TEST_PAYS_OFF) {
+    ASSERT_TRUE(HCMultiDecodeTable::paysOff(4.5));
+    ASSERT_FALSE(HCMultiDecodeTable::paysOff(8));
+}
@@ -192,4 +192,73 @@ TEST_F(SimpleHCTreeFixture, TEST_DECODE_BIS) {
     BitInputStream bis(ss);
 
     ASSERT_EQ(tree.decode(bis), 'C');
-}
\ No newline at end of file
+}
+TEST_F(SimpleHCTreeFixture, TEST_CODE_TABLE) {
+    const vector<HCCode>& codes = tree.getCodes();
+    ASSERT_EQ(codes['C'].bits, 5);
+    ASSERT_EQ(codes['C'].length, 3);
+    ASSERT_EQ(codes['F'].length, 0);
+}
+
+TEST_F(SimpleHCTreeFixture, TEST_ENCODE_TABLE_MATCHES_LEAF_WALK) {
+    stringstream table;
+    stringstream walk;
+    BitOutputStream bosTable(table);
+    BitOutputStream bosWalk(walk);
+
+    string symbols = "ABCDEEDCBAECADB";
+    for (char c : symbols) {
+        tree.encode(c, bosTable);
+        tree.encodeFromLeaf(c, bosWalk);
+    }
+
+    ASSERT_EQ(bosTable.flush(), bosWalk.flush());
+    ASSERT_EQ(table.str(), walk.str());
+}
+
+TEST_F(ManualHCTreeFixture, TEST_CODE_TABLE_NO_BUILD) {
+    ostringstream os;
+    tree->encode('A', os);
+    ASSERT_EQ(os.str(), "010");
+}
+
+TEST_F(SimpleHCTreeFixture, TEST_REBUILD) {
+    // building again starts over from an empty node array
+    vector<unsigned int> freqs(256);
+    for (int i = 0; i < 256; i++) freqs[i] = i + 1;
+    tree.build(freqs);
+
+    HCTree fresh;
+    fresh.build(freqs);
+    for (int i = 0; i < 256; i++) {
+        ASSERT_EQ(tree.getCodes()[i].bits, fresh.getCodes()[i].bits);
+        ASSERT_EQ(tree.getCodes()[i].length, fresh.getCodes()[i].length);
+    }
+
+    // the node array makes copies independent of the original
+    HCTree copy = tree;
+    tree.build(vector<unsigned int>(256, 1));
+    ASSERT_EQ(copy.getCodes()[255].length, fresh.getCodes()[255].length);
+}
+
+TEST(HCTreeBuildTests, TEST_TWO_QUEUE_MATCHES_PQ) {
+    srand(7);
+    for (int round = 0; round < 200; round++) {
+        // mix of few and many symbols, with lots of equal counts
+        vector<unsigned int> freqs(256);
+        int numSymbols = 1 + rand() % 256;
+        unsigned int maxCount = 1 + rand() % (round % 2 ? 5 : 100000);
+        for (int i = 0; i < numSymbols; i++) {
+            freqs[rand() % 256] = 1 + rand() % maxCount;
+        }
+
+        HCTree twoQueue;
+        HCTree pq;
+        twoQueue.build(freqs);
+        pq.buildWithPQ(freqs);
+        for (int i = 0; i < 256; i++) {
+            ASSERT_EQ(twoQueue.getCodes()[i].bits, pq.getCodes()[i].bits);
+            ASSERT_EQ(twoQueue.getCodes()[i].length, pq.getCodes()[i].length);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Histogram.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Check a kernel against a plain counting loop for every length up to 200
+ * and for a long input, starting at every alignment */
+static void checkKernel(void (*kernel)(const byte*, size_t,
+                                       vector<unsigned int>&),
+                        const vector<byte>& data) {
+    for (size_t start = 0; start < 32; start++) {
+        size_t lengths[] = {0, 1, 15, 16, 17, 31, 32, 33, 200,
+                            data.size() - start};
+        for (size_t n : lengths) {
+            vector<unsigned int> expected(256);
+            for (size_t i = 0; i < n; i++) expected[data[start + i]]++;
+
+            // kernels add to the counts already there
+            vector<unsigned int> freqs(256, 3);
+            kernel(data.data() + start, n, freqs);
+            for (int i = 0; i < 256; i++) {
+                ASSERT_EQ(freqs[i], expected[i] + 3);
+            }
+        }
+    }
+}
+
+/* Random bytes mixed with long runs of one byte */
+static vector<byte> testData() {
+    srand(42);
+    vector<byte> data;
+    while (data.size() < 100000) {
+        byte c = rand() % 256;
+        int run = (rand() % 4 == 0) ? rand() % 200 : 1;
+        data.insert(data.end(), run, c);
+    }
+    return data;
+}
+
+TEST(HistogramTests, TEST_SCALAR) {
+    checkKernel(Histogram::countScalar, testData());
+}
+
+TEST(HistogramTests, TEST_SSE2) {
+    if (!Histogram::hasSSE2()) return;
+    checkKernel(Histogram::countSSE2, testData());
+}
+
+TEST(HistogramTests, TEST_AVX2) {
+    if (!Histogram::hasAVX2()) return;
+    checkKernel(Histogram::countAVX2, testData());
+}
+
+TEST(HistogramTests, TEST_COUNT) {
+    string newlines(1000, '\n');
+    vector<unsigned int> freqs(256);
+    Histogram::count((const byte*)newlines.data(), newlines.size(), freqs);
+    ASSERT_EQ(freqs['\n'], 1000);
+    ASSERT_EQ(freqs['a'], 0);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "InputBuffer.hpp"
+
+using namespace std;
+using namespace testing;
+
+class InputBufferFixture : public ::testing::Test {
+  protected:
+    string fileName = "test_InputBuffer.tmp";
+
+    void writeFile(const string& contents) {
+        ofstream out(fileName, ios::binary);
+        out.write(contents.data(), contents.size());
+    }
+
+  public:
+    ~InputBufferFixture() { remove(fileName.c_str()); }
+};
+
+TEST_F(InputBufferFixture, TEST_MAPPED_FILE) {
+    string contents;
+    for (int i = 0; i < 100000; i++) contents += (char)(i % 251);
+    writeFile(contents);
+
+    InputBuffer in(fileName);
+    ASSERT_TRUE(in.isOpen());
+    ASSERT_EQ(in.size(), contents.size());
+    ASSERT_EQ(string((const char*)in.getData(), in.size()), contents);
+}
+
+TEST_F(InputBufferFixture, TEST_EMPTY_FILE) {
+    writeFile("");
+
+    InputBuffer in(fileName);
+    ASSERT_TRUE(in.isOpen());
+    ASSERT_EQ(in.size(), 0);
+}
+
+TEST_F(InputBufferFixture, TEST_MISSING_FILE) {
+    InputBuffer in("no_such_file.tmp");
+    ASSERT_FALSE(in.isOpen());
+}
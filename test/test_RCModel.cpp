@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Histogram.hpp"
+#include "RCModel.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Code input with a model seeded from its histogram, then decode it with a
+ * model built from the header. Returns the number of coded bytes */
+static size_t checkRoundTrip(const vector<byte>& input, unsigned int order) {
+    vector<unsigned int> freqs(256);
+    Histogram::count(input.data(), input.size(), freqs);
+    vector<unsigned int> seed = RCModel::makeSeed(freqs);
+
+    stringstream ss;
+    RCModel::writeHeader(ss, seed, order);
+    size_t headerSize = ss.str().size();
+    RCModel encoder(seed, order);
+    RangeEncoder rangeEncoder(ss);
+    for (byte c : input) encoder.encode(c, rangeEncoder);
+    rangeEncoder.flush();
+    size_t size = ss.str().size() - headerSize;
+
+    vector<unsigned int> readSeed;
+    unsigned int readOrder;
+    EXPECT_TRUE(RCModel::readHeader(ss, readSeed, readOrder));
+    EXPECT_EQ(readSeed, seed);
+    EXPECT_EQ(readOrder, order);
+    RCModel decoder(readSeed, readOrder);
+    RangeDecoder rangeDecoder(ss);
+    vector<byte> decoded;
+    for (size_t i = 0; i < input.size(); i++) {
+        decoded.push_back(decoder.decode(rangeDecoder));
+    }
+    EXPECT_EQ(decoded, input);
+    return size;
+}
+
+TEST(RCModelTests, TEST_SEED) {
+    vector<unsigned int> freqs(256, 0);
+    freqs['a'] = 1000000;
+    freqs['b'] = 1;
+    freqs['c'] = 500000;
+    vector<unsigned int> seed = RCModel::makeSeed(freqs);
+    ASSERT_EQ(seed['a'], RCModel::MAX_SEED);
+    ASSERT_EQ(seed['b'], 1u);
+    ASSERT_EQ(seed['c'], RCModel::MAX_SEED / 2);
+    ASSERT_EQ(seed['d'], 0u);
+}
+
+TEST(RCModelTests, TEST_TEXT) {
+    string text = "the range coder codes every byte in a fraction of a bit";
+    checkRoundTrip(vector<byte>(text.begin(), text.end()), 0);
+    checkRoundTrip(vector<byte>(text.begin(), text.end()), 1);
+}
+
+TEST(RCModelTests, TEST_ONE_SYMBOL) {
+    // the only byte there is costs nothing
+    ASSERT_LE(checkRoundTrip(vector<byte>(100000, '\n'), 0), 5u);
+}
+
+TEST(RCModelTests, TEST_ORDER1_LEARNS_CONTEXTS) {
+    // each byte follows from the one before it most of the time, which
+    // order 0 can't see
+    srand(33);
+    vector<byte> input(1, 'a');
+    for (int i = 0; i < 100000; i++) {
+        byte next = 'a' + (input.back() - 'a' + 1) % 26;
+        input.push_back(rand() % 10 == 0 ? 'a' + rand() % 26 : next);
+    }
+    size_t order0 = checkRoundTrip(input, 0);
+    size_t order1 = checkRoundTrip(input, 1);
+    ASSERT_LT(order1, order0 / 2);
+}
+
+TEST(RCModelTests, TEST_ALL_SYMBOLS) {
+    // long enough for every table to be halved many times
+    srand(34);
+    vector<byte> input;
+    for (int i = 0; i < 256; i++) input.push_back(i);
+    for (int i = 0; i < 300000; i++) {
+        input.push_back(rand() % 256 & rand() % 256);
+    }
+    checkRoundTrip(input, 0);
+    checkRoundTrip(input, 1);
+}
+
+TEST(RCModelTests, TEST_DAMAGED_HEADER) {
+    vector<unsigned int> seed;
+    unsigned int order;
+    stringstream badOrder(string("\x02\x01\x00\x41\x05", 5));
+    ASSERT_FALSE(RCModel::readHeader(badOrder, seed, order));
+
+    stringstream zeroSeed(string("\x00\x01\x00\x41\x00", 5));
+    ASSERT_FALSE(RCModel::readHeader(zeroSeed, seed, order));
+
+    stringstream truncated(string("\x01\x02\x00\x41\x05", 5));
+    ASSERT_FALSE(RCModel::readHeader(truncated, seed, order));
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "RangeCoder.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Code symbols with fixed frequencies and decode them again. Returns the
+ * number of coded bytes */
+static size_t checkRoundTrip(const vector<unsigned int>& symbols,
+                             const vector<uint32_t>& freqs) {
+    vector<uint32_t> cumFreqs(freqs.size() + 1, 0);
+    for (size_t s = 0; s < freqs.size(); s++) {
+        cumFreqs[s + 1] = cumFreqs[s] + freqs[s];
+    }
+    uint32_t total = cumFreqs.back();
+
+    stringstream ss;
+    RangeEncoder encoder(ss, 16);
+    for (unsigned int s : symbols) encoder.encode(cumFreqs[s], freqs[s], total);
+    encoder.flush();
+    size_t size = ss.str().size();
+
+    RangeDecoder decoder(ss, 16);
+    for (unsigned int s : symbols) {
+        uint32_t freq = decoder.getFreq(total);
+        unsigned int found = 0;
+        while (cumFreqs[found + 1] <= freq) found++;
+        EXPECT_EQ(found, s);
+        decoder.decode(cumFreqs[found], freqs[found]);
+    }
+    EXPECT_FALSE(decoder.isExhausted());
+    return size;
+}
+
+TEST(RangeCoderTests, TEST_UNIFORM) {
+    // 256 equally likely symbols take a byte each, plus the flushed range
+    srand(31);
+    vector<unsigned int> symbols;
+    for (int i = 0; i < 10000; i++) symbols.push_back(rand() % 256);
+    size_t size = checkRoundTrip(symbols, vector<uint32_t>(256, 1));
+    ASSERT_LE(size, 10000u + 5);
+}
+
+TEST(RangeCoderTests, TEST_FRACTIONAL_BITS) {
+    // p = 0.99 and 0.01 carry 0.081 bits per symbol
+    srand(32);
+    vector<unsigned int> symbols;
+    for (int i = 0; i < 100000; i++) symbols.push_back(rand() % 100 == 0);
+    size_t size = checkRoundTrip(symbols, {99, 1});
+    ASSERT_LT(size, 100000 * 0.09 / 8);
+}
+
+TEST(RangeCoderTests, TEST_CARRY) {
+    // the most likely symbol at the top of the range makes long runs of
+    // 0xFF bytes that a carry has to go through
+    vector<unsigned int> symbols(50000, 1);
+    for (int i = 0; i < 50000; i += 997) symbols[i] = 0;
+    checkRoundTrip(symbols, {1, RangeEncoder::MAX_TOTAL - 1});
+}
+
+TEST(RangeCoderTests, TEST_EXHAUSTED) {
+    // decoding more symbols than were coded runs off the end of the input
+    stringstream ss;
+    RangeEncoder encoder(ss);
+    for (int i = 0; i < 1000; i++) encoder.encode(i % 4, 1, 4);
+    encoder.flush();
+
+    RangeDecoder decoder(ss);
+    for (int i = 0; i < 1000; i++) {
+        uint32_t freq = decoder.getFreq(4);
+        ASSERT_EQ(freq, (uint32_t)i % 4);
+        decoder.decode(freq, 1);
+    }
+    ASSERT_FALSE(decoder.isExhausted());
+    for (int i = 0; i < 100 && !decoder.isExhausted(); i++) {
+        decoder.decode(decoder.getFreq(4), 1);
+    }
+    ASSERT_TRUE(decoder.isExhausted());
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Histogram.hpp"
+#include "TunstallCode.hpp"
+
+using namespace std;
+using namespace testing;
+
+/* Encode input with a code built from its histogram, then decode it with a
+ * code built from the header. Returns the number of bytes the codewords
+ * took */
+static size_t checkRoundTrip(const vector<byte>& input,
+                             unsigned int codeBits) {
+    vector<unsigned int> freqs(256);
+    Histogram::count(input.data(), input.size(), freqs);
+    TunstallCode encoder(freqs, codeBits);
+
+    stringstream ss;
+    encoder.writeHeader(ss);
+    size_t headerSize = ss.str().size();
+    BitOutputStream bos(ss, 4096);
+    encoder.encode(input.data(), input.size(), bos);
+    bos.flush();
+    size_t size = ss.str().size() - headerSize;
+
+    vector<unsigned int> readFreqs;
+    unsigned int readCodeBits;
+    EXPECT_TRUE(TunstallCode::readHeader(ss, readFreqs, readCodeBits));
+    EXPECT_EQ(readFreqs, TunstallCode::normalize(freqs));
+    TunstallCode decoder(readFreqs, readCodeBits);
+
+    // decode in small pieces to check the strings carried over
+    BitInputStream bis(ss, 4096);
+    vector<byte> decoded(input.size() + 1000 + TunstallCode::MAX_STRING_LENGTH);
+    size_t pos = 0;
+    while (pos < input.size()) {
+        size_t n = min((size_t)1000, input.size() - pos);
+        pos += decoder.decode(bis, decoded.data() + pos, n);
+    }
+    EXPECT_FALSE(bis.isExhausted());
+    decoded.resize(input.size());
+    EXPECT_EQ(decoded, input);
+    return size;
+}
+
+TEST(TunstallCodeTests, TEST_NORMALIZE) {
+    vector<unsigned int> freqs(256, 0);
+    freqs['a'] = 1000000;
+    freqs['b'] = 1;
+    freqs['c'] = 3;
+    vector<unsigned int> scaled = TunstallCode::normalize(freqs);
+    ASSERT_EQ(scaled['b'], 1u);
+    ASSERT_EQ(scaled['c'], 1u);
+    ASSERT_EQ(scaled['a'], TunstallCode::FREQ_TOTAL - 2);
+    ASSERT_EQ(scaled['d'], 0u);
+
+    // normalized frequencies stay the same
+    ASSERT_EQ(TunstallCode::normalize(scaled), scaled);
+}
+
+TEST(TunstallCodeTests, TEST_DICTIONARY_SIZE) {
+    vector<unsigned int> freqs(256, 0);
+    freqs['a'] = 3;
+    freqs['b'] = 2;
+    freqs['c'] = 1;
+    // 3 leaves, then 2 more per expansion, up to 4096 codewords
+    TunstallCode code(freqs);
+    ASSERT_EQ(code.getCodeBits(), TunstallCode::DEFAULT_CODE_BITS);
+    ASSERT_EQ(code.size(), 4096u);
+}
+
+TEST(TunstallCodeTests, TEST_TEXT) {
+    string text = "variable length strings in, fixed length codewords out";
+    checkRoundTrip(vector<byte>(text.begin(), text.end()), 12);
+    checkRoundTrip(vector<byte>(text.begin(), text.end()), 8);
+}
+
+TEST(TunstallCodeTests, TEST_ONE_SYMBOL) {
+    // strings of MAX_STRING_LENGTH bytes, the last one cut short
+    vector<byte> input(1000, '\n');
+    size_t size = checkRoundTrip(input, 12);
+    ASSERT_EQ(size, (1000 / 64 + 1) * 12 / 8);
+    checkRoundTrip(vector<byte>(1, 'x'), 12);
+}
+
+TEST(TunstallCodeTests, TEST_SKEWED) {
+    // about 0.5 bits of information per byte, long strings per codeword
+    srand(21);
+    vector<byte> input;
+    for (int i = 0; i < 100000; i++) {
+        input.push_back(rand() % 16 == 0 ? rand() % 4 : 'z');
+    }
+    size_t size = checkRoundTrip(input, 12);
+    ASSERT_LT(size, input.size() / 8);
+}
+
+TEST(TunstallCodeTests, TEST_ALL_SYMBOLS) {
+    srand(22);
+    vector<byte> input;
+    for (int i = 0; i < 256; i++) input.push_back(i);
+    for (int i = 0; i < 50000; i++) {
+        input.push_back(rand() % 256 & rand() % 256);
+    }
+    for (unsigned int codeBits = TunstallCode::MIN_CODE_BITS;
+         codeBits <= TunstallCode::MAX_CODE_BITS; codeBits += 4) {
+        checkRoundTrip(input, codeBits);
+    }
+}
+
+TEST(TunstallCodeTests, TEST_DAMAGED_HEADER) {
+    vector<unsigned int> freqs;
+    unsigned int codeBits;
+    stringstream badBits(string("\x20\x01\x00", 3));
+    ASSERT_FALSE(TunstallCode::readHeader(badBits, freqs, codeBits));
+
+    // one symbol whose frequency doesn't add up to FREQ_TOTAL
+    stringstream badTotal(string("\x0c\x01\x00\x41\x00\x10", 6));
+    ASSERT_FALSE(TunstallCode::readHeader(badTotal, freqs, codeBits));
+
+    stringstream truncated(string("\x0c\x02\x00\x41", 4));
+    ASSERT_FALSE(TunstallCode::readHeader(truncated, freqs, codeBits));
+}
+
+TEST(TunstallCodeTests, TEST_TRUNCATED_STREAM) {
+    string text = "a truncated stream runs out of codewords, ";
+    vector<byte> input;
+    for (int i = 0; i < 100; i++) {
+        input.insert(input.end(), text.begin(), text.end());
+    }
+    vector<unsigned int> freqs(256);
+    Histogram::count(input.data(), input.size(), freqs);
+    TunstallCode code(freqs);
+
+    stringstream ss;
+    BitOutputStream bos(ss, 4096);
+    code.encode(input.data(), input.size(), bos);
+    bos.flush();
+
+    // only half of the codewords are left to decode
+    string data = ss.str();
+    stringstream half(data.substr(0, data.size() / 2));
+    BitInputStream bis(half, 4096);
+    vector<byte> decoded(input.size() + TunstallCode::MAX_STRING_LENGTH);
+    code.decode(bis, decoded.data(), input.size());
+    ASSERT_TRUE(bis.isExhausted());
+}